@@ -0,0 +1,359 @@
+// Microbenchmarks for the emulator's hot paths. Prints Google Benchmark style JSON (so compare.py and the usual
+// dashboards can read it) on stdout, or to --out <file>:
+//   bench [--filter <substring>] [--min-time <ms>] [--out <file>]
+// Every benchmark is rerun with a growing iteration count until one run takes at least --min-time (default 200ms), and
+// that run is reported. real_time and cpu_time are per iteration, in ns.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+
+#include "console.h"
+#include "process.h"
+#include "memoryAllocator.h"
+#include "processTable.h"
+#include "lockStat.h"
+#include "latency.h"
+#include "wallClock.h"
+
+using std::string;
+using std::vector;
+using process::Process;
+using console::Console;
+using console::MainConsole;
+
+namespace bench {
+
+	//Handed to a benchmark body: how many iterations to run, and a way to leave setup out of the timing.
+	class State {
+		public:
+			const uint64_t iterations;
+
+			explicit State(uint64_t n) : iterations(n) {}
+
+			void PauseTiming(){ pausedAt = latency::NowNs(); }
+			void ResumeTiming(){ paused += latency::NowNs() - pausedAt; }
+
+			//Reported as items_per_second, for benchmarks where an iteration isn't the natural unit.
+			void ItemsProcessed(uint64_t n){ items = n; }
+
+			//Extra numbers for the JSON entry, e.g. how often an allocation fit.
+			void Counter(const string& name, double value){
+				for(auto& c : counters) if(c.first == name){ c.second = value; return; }
+				counters.push_back({name, value});
+			}
+
+		private:
+			friend class Runner;
+			uint64_t pausedAt = 0;
+			uint64_t paused = 0;
+			uint64_t items = 0;
+			vector<std::pair<string, double>> counters;
+	};
+
+	struct Result {
+		string name;
+		uint64_t iterations;
+		double realNs;		//per iteration
+		double cpuNs;		//per iteration, process CPU time, so it adds up every thread the body starts
+		vector<std::pair<string, double>> counters;
+	};
+
+	class Runner {
+		public:
+			string filter;
+			uint64_t minTimeNs = 200 * 1000000ull;
+			vector<Result> results;
+
+			void Run(const string& name, std::function<void(State&)> body){
+				if(!filter.empty() && name.find(filter) == string::npos) return;
+				uint64_t n = 1;
+				while(true){
+					State state(n);
+					std::clock_t cpuStart = std::clock();
+					uint64_t start = latency::NowNs();
+					body(state);
+					uint64_t total = latency::NowNs() - start;
+					uint64_t elapsed = total - state.paused;
+					//clock() is too coarse to pause around single calls, so paused time comes off the CPU time pro rata
+					double cpu = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC * 1e9 * ((total > 0) ? (double)elapsed / total : 1);
+					if(elapsed >= minTimeNs || n >= (1ull << 40)){
+						if(state.items > 0) state.Counter("items_per_second", state.items / (elapsed / 1e9));
+						results.push_back({name, n, (double)elapsed / n, cpu / n, state.counters});
+						std::cerr << name << ": " << n << " iterations, " << (double)elapsed / n << " ns" << std::endl;
+						return;
+					}
+					//Aim a bit past minTime from what this run took, at least double, at most 100x
+					double scale = (elapsed > 0) ? (double)minTimeNs * 1.4 / elapsed : 100;
+					n = (uint64_t)(n * std::min(std::max(scale, 2.0), 100.0));
+				}
+			}
+
+			void WriteJson(std::ostream& out, const char* executable){
+				char date[32];
+				struct tm now;
+				wallClock::Convert(time(NULL), now);
+				strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &now);
+				out << "{\n  \"context\": {\n";
+				out << "    \"date\": \"" << date << "\",\n";
+				out << "    \"executable\": \"" << escape(executable) << "\",\n";
+				out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+				out << "    \"library_build_type\": \"release\",\n";
+#else
+				out << "    \"library_build_type\": \"debug\",\n";
+#endif
+				out << "    \"min_time_ms\": " << minTimeNs / 1000000 << "\n  },\n";
+				out << "  \"benchmarks\": [";
+				for(size_t i = 0; i < results.size(); i++){
+					const Result& r = results[i];
+					char times[128];
+					snprintf(times, sizeof(times), "\"real_time\": %.3f, \"cpu_time\": %.3f", r.realNs, r.cpuNs);
+					out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape(r.name) << "\", \"run_name\": \"" << escape(r.name)
+					    << "\", \"run_type\": \"iteration\", \"iterations\": " << r.iterations << ", " << times << ", \"time_unit\": \"ns\"";
+					for(auto& c : r.counters){
+						char value[64];
+						snprintf(value, sizeof(value), "%.6g", c.second);
+						out << ", \"" << escape(c.first) << "\": " << value;
+					}
+					out << "}";
+				}
+				out << "\n  ]\n}\n";
+			}
+
+		private:
+			static string escape(const string& s){
+				string out;
+				for(char c : s){
+					if(c == '"' || c == '\\') out += '\\';
+					out += c;
+				}
+				return out;
+			}
+	};
+
+	//Discards what the code under test prints (MainConsole's banner, "Report generated!") so stdout stays JSON.
+	class NullBuffer : public std::streambuf {
+		protected:
+			int overflow(int c) override { return traits_type::not_eof(c); }
+			std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+	};
+}
+
+static const int memPerFrame = 256;
+static const int numFrames = 4096;
+
+//Memory half full, in alternating used and free runs of holeFrames frames: the smaller the runs, the more fragmented.
+//holeFrames 0 leaves it empty. The residents are returned so they outlive the benchmark.
+static vector<std::unique_ptr<Process>> fragment(memoryAllocator::MemoryAllocator& memory, int holeFrames){
+	vector<std::unique_ptr<Process>> resident;
+	if(holeFrames == 0) return resident;
+	for(int pid = 1; ; pid++){
+		std::unique_ptr<Process> p(new Process("resident", pid));
+		p->size = holeFrames * memPerFrame;
+		if(!memory.AllocateProcessContiguous(*p)) break;
+		resident.push_back(std::move(p));
+	}
+	vector<std::unique_ptr<Process>> kept;
+	for(size_t i = 0; i < resident.size(); i++){
+		if(i % 2) memory.DeallocateProcess(*resident[i]);
+		else kept.push_back(std::move(resident[i]));
+	}
+	return kept;
+}
+
+//Every run leaves memory as it found it (whatever it allocates it frees), so the layout is built once per benchmark.
+static void allocatorBenchmarks(bench::Runner& runner){
+	const int holes[] = { 0, 16, 4, 1 };
+	for(int hole : holes){
+		string layout = (hole == 0) ? "empty" : "holes:" + std::to_string(hole);
+		for(int contiguous = 0; contiguous < 2; contiguous++){
+			memoryAllocator::MemoryAllocator memory(numFrames * memPerFrame, memPerFrame);
+			auto resident = fragment(memory, hole);
+			string name = string("MemoryAllocator/") + (contiguous ? "AllocateProcessContiguous/" : "AllocateProcess/") + layout;
+			runner.Run(name, [&](bench::State& state){
+				Process p("bench", 1000000);
+				p.size = 8 * memPerFrame;
+				uint64_t fits = 0;
+				for(uint64_t i = 0; i < state.iterations; i++){
+					bool ok = contiguous ? memory.AllocateProcessContiguous(p) : memory.AllocateProcess(p);
+					if(!ok) continue;
+					fits++;
+					state.PauseTiming();
+					memory.DeallocateProcess(p);
+					state.ResumeTiming();
+				}
+				state.Counter("fit_rate", (double)fits / state.iterations);
+			});
+		}
+		memoryAllocator::MemoryAllocator memory(numFrames * memPerFrame, memPerFrame);
+		auto resident = fragment(memory, hole);
+		runner.Run("MemoryAllocator/DeallocateProcess/" + layout, [&](bench::State& state){
+			Process p("bench", 1000000);
+			p.size = 8 * memPerFrame;
+			for(uint64_t i = 0; i < state.iterations; i++){
+				state.PauseTiming();
+				bool ok = memory.AllocateProcess(p);
+				state.ResumeTiming();
+				if(ok) memory.DeallocateProcess(p);
+			}
+		});
+	}
+}
+
+//One instruction per iteration through the same path a core takes: handleInput on the current command, then pop it.
+static void dispatchBenchmarks(bench::Runner& runner){
+	struct Case { const char* name; const char* command; };
+	const Case cases[] = {
+		{ "print", "print(Hello World from bench)" },
+		{ "declare", "declare var 1" },
+		{ "add", "add var1 var2 var3" },
+		{ "subtract", "subtract var1 var2 var3" },
+		{ "sleep", "sleep(50)" },
+		{ "for", "for([declare(var,value)],3))" },
+	};
+	for(const Case& c : cases){
+		runner.Run(string("Console/handleInput/") + c.name, [&](bench::State& state){
+			Console console(Process("bench", 1));
+			for(uint64_t i = 0; i < state.iterations; i++){
+				console.handleInput(c.command);
+				if(console.process.log.size() > 4096){
+					state.PauseTiming();
+					console.process.log.clear();
+					state.ResumeTiming();
+				}
+			}
+		});
+	}
+	runner.Run("Console/handleInput/generated", [&](bench::State& state){
+		Console console(Process(12345u, "bench", 1, 1000, 4096));
+		for(uint64_t i = 0; i < state.iterations; i++){
+			if(!console.process.HasCommand()){
+				state.PauseTiming();
+				console.process.nextCommand = 0;
+				console.process.log.clear();
+				state.ResumeTiming();
+			}
+			console.handleInput(console.process.CurrentCommand());
+			console.process.PopCommand();
+		}
+	});
+}
+
+static void processBenchmarks(bench::Runner& runner){
+	runner.Run("Process/generated/lines:100-200", [&](bench::State& state){
+		for(uint64_t i = 0; i < state.iterations; i++){
+			Process p("process_" + std::to_string(i), (int)i, 100, 200, 1024, 4096);
+		}
+	});
+	runner.Run("Process/replayed/lines:150", [&](bench::State& state){
+		for(uint64_t i = 0; i < state.iterations; i++){
+			Process p((uint32_t)i, "process", (int)i, 150, 1024);
+		}
+	});
+}
+
+//enqueue + dequeue pairs on the ready queue, under queueMutex the way the generator and the cores take it, from several
+//threads at once. The cores are shut down first so nothing else touches the queue.
+static void queueBenchmarks(bench::Runner& runner, MainConsole& mainConsole){
+	const int threadCounts[] = { 1, 2, 4, 8 };
+	Console console(Process(7u, "bench", 1, 150, 1024));
+	for(int threads : threadCounts){
+		runner.Run("ReadyQueue/enqueue+dequeue/threads:" + std::to_string(threads), [&](bench::State& state){
+			vector<std::thread> workers;
+			for(int t = 0; t < threads; t++){
+				workers.emplace_back([&, t]{
+					uint64_t pairs = state.iterations / threads + (t < (int)(state.iterations % threads) ? 1 : 0);
+					for(uint64_t i = 0; i < pairs; i++){
+						{
+							lockStat::Lock lock(mainConsole.queueMutex, "bench: enqueue");
+							mainConsole.enqueue(console, t % (mainConsole.numCPU + 2));
+						}
+						lockStat::Lock lock(mainConsole.queueMutex, "bench: dequeue");
+						if(!mainConsole.processQueue.empty()) mainConsole.dequeue();
+					}
+				});
+			}
+			for(auto& w : workers) w.join();
+			state.ItemsProcessed(state.iterations);
+		});
+	}
+}
+
+//report-util with rows finished processes in the table, in each format. One iteration is one whole report.
+static void reportBenchmarks(bench::Runner& runner, MainConsole& mainConsole){
+	const int rows = 100000;
+	const char* path = "bench-report.tmp";
+	mainConsole.finishedRetention = 0; //keep them all in memory
+	{
+		lockStat::Lock lock(mainConsole.processStatusMutex, "bench: fill");
+		for(int pid = 1; pid <= rows; pid++){
+			Process p("process_" + std::to_string(pid), pid);
+			p.lineCount = p.currLine = 100 + pid % 100;
+			p.size = 1024;
+			time(&p.arrivalTime);
+			p.startTime = p.finishTime = p.arrivalTime;
+			p.lastCore = pid % 4;
+			mainConsole.finishedRows.Push(processTable::RowOf(p, mainConsole.memManager.memoryPerFrame));
+		}
+	}
+	struct Format { const char* name; processTable::Format format; };
+	const Format formats[] = { { "text", processTable::Text }, { "csv", processTable::CSV }, { "jsonl", processTable::JSONL } };
+	for(const Format& f : formats){
+		runner.Run(string("MainConsole/printProcessesToFile/rows:") + std::to_string(rows) + "/format:" + f.name, [&](bench::State& state){
+			for(uint64_t i = 0; i < state.iterations; i++) mainConsole.printProcessesToFile(f.format, path);
+			state.ItemsProcessed(state.iterations * rows);
+		});
+	}
+	remove(path);
+}
+
+int main(int argc, char* argv[]){
+	bench::Runner runner;
+	const char* outPath = NULL;
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) runner.filter = argv[++i];
+		else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) runner.minTimeNs = (uint64_t)atol(argv[++i]) * 1000000ull;
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+		else{
+			std::cerr << "usage: " << argv[0] << " [--filter <substring>] [--min-time <ms>] [--out <file>]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	bench::NullBuffer discard;
+	std::streambuf* stdoutBuffer = std::cout.rdbuf(&discard);
+
+	allocatorBenchmarks(runner);
+	dispatchBenchmarks(runner);
+	processBenchmarks(runner);
+	{
+		MainConsole mainConsole(1, "fcfs", 5, 10, 100, 200, 0, numFrames * memPerFrame, memPerFrame, 1024, 4096);
+		mainConsole.shutdown();
+		queueBenchmarks(runner, mainConsole);
+		reportBenchmarks(runner, mainConsole);
+	}
+
+	std::cout.rdbuf(stdoutBuffer);
+	if(outPath == NULL){
+		runner.WriteJson(std::cout, argv[0]);
+		return 0;
+	}
+	std::ofstream out(outPath);
+	if(!out){
+		std::cerr << "Could not open " << outPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	runner.WriteJson(out, argv[0]);
+	return 0;
+}
@@ -0,0 +1,219 @@
+#pragma once
+#ifndef configH
+#define configH
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+
+typedef struct {
+    int num_cpu;
+    char scheduler[10];
+    int quantum_cycles;
+    int batch_process_freq;
+    int min_ins;
+    int max_ins;
+    int delay_per_exec;
+    int max_overall_mem;
+    int mem_per_frame;
+    int min_mem_per_proc;
+    int max_mem_per_proc;
+    char replacement_policy[10];
+    char tlb_mode[10];
+    char allocator[12];
+    int compaction;
+    int compaction_threshold;
+    int memory_snapshots;
+    int finished_retention;
+} Config;
+
+// Copies a config string value into its fixed-size field, without the surrounding quotes if it has them.
+inline void setConfigString(char* field, size_t size, const char* value) {
+    size_t len = strlen(value);
+    if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+        value++;
+        len -= 2;
+    }
+    len = std::min(len, size - 1);
+    memcpy(field, value, len);
+    field[len] = '\0';
+}
+
+// An on/off setting: on/off, true/false or 1/0. False (out untouched) for anything else.
+inline bool parseSwitch(const char* value, int& out) {
+    const char* on[] = { "on", "true", "1" };
+    const char* off[] = { "off", "false", "0" };
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(value, on[i]) == 0) { out = 1; return true; }
+        if (strcmp(value, off[i]) == 0) { out = 0; return true; }
+    }
+    return false;
+}
+
+// A whole decimal number that fits an int. False (out untouched) for "abc", "10ms" or anything out of range.
+inline bool parseInt(const char* value, int& out) {
+    char* end = NULL;
+    errno = 0;
+    long n = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno == ERANGE || n < INT_MIN || n > INT_MAX) return false;
+    out = (int)n;
+    return true;
+}
+
+// Applies one "key value" setting. Used for every line of the config file, each value of a --sweep grid and config set.
+// Returns why the setting was rejected (unknown key, bad value), or NULL if it was applied.
+inline const char* setConfigValue(Config& config, const char* key, const char* value) {
+    if (strcmp(key, "num-cpu") == 0) {
+        if (!parseInt(value, config.num_cpu)) return "expects a number";
+    } else if (strcmp(key, "scheduler") == 0) {
+        setConfigString(config.scheduler, sizeof(config.scheduler), value);
+    } else if (strcmp(key, "replacement-policy") == 0) {
+        setConfigString(config.replacement_policy, sizeof(config.replacement_policy), value);
+    } else if (strcmp(key, "tlb-mode") == 0) {
+        setConfigString(config.tlb_mode, sizeof(config.tlb_mode), value);
+    } else if (strcmp(key, "allocator") == 0) {
+        setConfigString(config.allocator, sizeof(config.allocator), value);
+    } else if (strcmp(key, "compaction") == 0) {
+        if (!parseSwitch(value, config.compaction)) return "expects on or off";
+    } else if (strcmp(key, "memory-snapshots") == 0) {
+        if (!parseSwitch(value, config.memory_snapshots)) return "expects on or off";
+    } else if (strcmp(key, "finished-retention") == 0) {
+        if (!parseInt(value, config.finished_retention)) return "expects a number";
+    } else if (strcmp(key, "compaction-threshold") == 0) {
+        if (!parseInt(value, config.compaction_threshold)) return "expects a number";
+    } else if (strcmp(key, "quantum-cycles") == 0) {
+        if (!parseInt(value, config.quantum_cycles)) return "expects a number";
+    } else if (strcmp(key, "batch-process-freq") == 0) {
+        if (!parseInt(value, config.batch_process_freq)) return "expects a number";
+    } else if (strcmp(key, "min-ins") == 0) {
+        if (!parseInt(value, config.min_ins)) return "expects a number";
+    } else if (strcmp(key, "max-ins") == 0) {
+        if (!parseInt(value, config.max_ins)) return "expects a number";
+    } else if (strcmp(key, "delays-per-exec") == 0) {
+        if (!parseInt(value, config.delay_per_exec)) return "expects a number";
+    } else if (strcmp(key, "max-overall-mem") == 0) {
+        if (!parseInt(value, config.max_overall_mem)) return "expects a number";
+    } else if (strcmp(key, "mem-per-frame") == 0) {
+        if (!parseInt(value, config.mem_per_frame)) return "expects a number";
+    } else if (strcmp(key, "min-mem-per-proc") == 0) {
+        if (!parseInt(value, config.min_mem_per_proc)) return "expects a number";
+    } else if (strcmp(key, "max-mem-per-proc") == 0) {
+        if (!parseInt(value, config.max_mem_per_proc)) return "expects a number";
+    } else {
+        return "unknown config key";
+    }
+    return NULL;
+}
+
+// Reads path over the defaults. False if it can't be opened; unknown keys and malformed lines are reported and skipped.
+inline bool loadConfig(const char* path, Config& config) {
+    config = Config{};
+    strcpy(config.replacement_policy, "none");
+    strcpy(config.tlb_mode, "flush");
+    strcpy(config.allocator, "paging");
+    config.compaction_threshold = 50;
+    config.finished_retention = 1000;
+    FILE* file = fopen(path, "r");
+
+    if (!file) {
+        std::cerr << "Error opening " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        // Remove trailing newline
+        line[strcspn(line, "\r\n")] = 0;
+
+        char key[64] = {0};
+        char value[64] = {0};
+
+        if (sscanf(line, "%63s %63[^\n]", key, value) == 2) {
+            // Strip trailing newlines/spaces from value
+            value[strcspn(value, "\r\n")] = 0;
+
+            if (const char* error = setConfigValue(config, key, value))
+                std::cerr << path << ": " << key << " " << value << ": " << error << std::endl;
+        } else {
+            std::cerr << "Malformed line in " << path << ": " << line << std::endl;
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+inline Config configSetup(const char* path = "config.txt") {
+    Config config;
+    if (!loadConfig(path, config)) exit(EXIT_FAILURE);
+    return config;
+}
+
+// The settings a running emulator picks up without a restart (config set / config reload). A published snapshot is
+// never changed; cores and the scheduler take the current one at a quantum boundary and keep it for the quantum.
+struct Tunables {
+    int quantumCycles;
+    int batchProcessFreq;
+    int minIns;
+    int maxIns;
+    int delayPerExec;
+    int minMemPerProc;
+    int maxMemPerProc;
+    uint64_t version = 0;   //1 for the config read at startup, +1 per change
+};
+
+inline Tunables TunablesOf(const Config& config) {
+    Tunables t;
+    t.quantumCycles = config.quantum_cycles;
+    t.batchProcessFreq = config.batch_process_freq;
+    t.minIns = config.min_ins;
+    t.maxIns = config.max_ins;
+    t.delayPerExec = config.delay_per_exec;
+    t.minMemPerProc = config.min_mem_per_proc;
+    t.maxMemPerProc = config.max_mem_per_proc;
+    return t;
+}
+
+// Writes t back into the matching config fields.
+inline void applyTunables(Config& config, const Tunables& t) {
+    config.quantum_cycles = t.quantumCycles;
+    config.batch_process_freq = t.batchProcessFreq;
+    config.min_ins = t.minIns;
+    config.max_ins = t.maxIns;
+    config.delay_per_exec = t.delayPerExec;
+    config.min_mem_per_proc = t.minMemPerProc;
+    config.max_mem_per_proc = t.maxMemPerProc;
+}
+
+inline bool isLiveSetting(const char* key) {
+    const char* live[] = { "quantum-cycles", "batch-process-freq", "min-ins", "max-ins", "delays-per-exec", "min-mem-per-proc", "max-mem-per-proc" };
+    for (const char* k : live)
+        if (strcmp(key, k) == 0) return true;
+    return false;
+}
+
+// Why t can't be published, or NULL if it can.
+inline const char* invalidTunables(const Tunables& t) {
+    if (t.quantumCycles < 1) return "quantum-cycles must be at least 1";
+    if (t.batchProcessFreq < 0 || t.delayPerExec < 0) return "batch-process-freq and delays-per-exec can't be negative";
+    if (t.minIns < 1 || t.maxIns < t.minIns) return "min-ins must be at least 1 and no more than max-ins";
+    if (t.minMemPerProc < 1 || t.maxMemPerProc < t.minMemPerProc) return "min-mem-per-proc must be at least 1 and no more than max-mem-per-proc";
+    return NULL;
+}
+
+// True if a and b only differ in live settings.
+inline bool sameRestartSettings(const Config& a, const Config& b) {
+    return a.num_cpu == b.num_cpu && strcmp(a.scheduler, b.scheduler) == 0
+        && a.max_overall_mem == b.max_overall_mem && a.mem_per_frame == b.mem_per_frame
+        && strcmp(a.replacement_policy, b.replacement_policy) == 0 && strcmp(a.tlb_mode, b.tlb_mode) == 0
+        && strcmp(a.allocator, b.allocator) == 0 && a.compaction == b.compaction
+        && a.compaction_threshold == b.compaction_threshold && a.memory_snapshots == b.memory_snapshots
+        && a.finished_retention == b.finished_retention;
+}
+
+#endif
@@ -14,11 +14,29 @@
 #include <chrono>
 #include <regex>
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <climits>
 
 #include "process.h" //This is for the process class
 #include "memoryAllocator.h" //This is for the memory allocator class
 #include "frame.h"
 #include "stats.h"
+#include "cpuCore.h"
+#include "snapshotStream.h"
+#include "processPool.h"
+#include "processTable.h"
+#include "processArchive.h"
+#include "processIndex.h"
+#include "latency.h"
+#include "trace.h"
+#include "lockStat.h"
+#include "metricsExport.h"
+#include "terminalScreen.h"
+#include "wallClock.h"
+#include "virtualClock.h"
+#include "workload.h"
+#include "config.h"
 
 using std::left;
 using std::right;
@@ -39,24 +57,41 @@ using std::regex_replace;
 using std::atomic;
 
 
-inline void printVMStat(memoryAllocator::MemoryAllocator &allocator) {
+// Everything vmstat and process-smi show, read from counters the allocator and cores keep up to date. O(cores), no frame walk, no locks.
+// scheduler is the round-robin scheduler's own ticks (it runs processes itself), added to the totals.
+inline VMStat collectVMStat(memoryAllocator::MemoryAllocator &allocator, std::deque<cpucore::Core> &cores, const cpucore::Ticks &scheduler) {
     VMStat stats{};
     stats.totalMemory = allocator.maxMemory;
+    stats.usedMemory = allocator.UsedFrames() * allocator.memoryPerFrame;
+    stats.freeMemory = stats.totalMemory - stats.usedMemory;
 
-    // Count used frames
-    uint64_t usedFrames = 0;
-    for (auto &f : allocator.frames) {
-        if (!f.pid.empty()) usedFrames++;
+    for (auto &c : cores) {
+        stats.idleCpuTicks += c.ticks.idle.load(std::memory_order_relaxed);
+        stats.activeCpuTicks += c.ticks.busy.load(std::memory_order_relaxed);
+        stats.switchCpuTicks += c.ticks.contextSwitch.load(std::memory_order_relaxed);
+        stats.sleepCpuTicks += c.ticks.sleepWait.load(std::memory_order_relaxed);
+        stats.contextSwitches += c.contextSwitches.load(std::memory_order_relaxed);
+        if (c.busy.load(std::memory_order_relaxed)) stats.busyCores++;
     }
-    stats.usedMemory = usedFrames * allocator.memoryPerFrame;
-    stats.freeMemory = stats.totalMemory - stats.usedMemory;
+    stats.idleCpuTicks += scheduler.idle.load(std::memory_order_relaxed);
+    stats.activeCpuTicks += scheduler.busy.load(std::memory_order_relaxed);
+    stats.switchCpuTicks += scheduler.contextSwitch.load(std::memory_order_relaxed);
+    stats.sleepCpuTicks += scheduler.sleepWait.load(std::memory_order_relaxed);
+    stats.totalCpuTicks = stats.idleCpuTicks + stats.activeCpuTicks + stats.switchCpuTicks + stats.sleepCpuTicks;
+    stats.numCores = cores.size();
+
+    stats.pagedIn = allocator.pagedIn;
+    stats.pagedOut = allocator.pagedOut;
+    return stats;
+}
+
+// Busy share of all core ticks since start, in percent.
+inline double CpuUtilization(const VMStat &stats) {
+    return (stats.totalCpuTicks > 0) ? (double)stats.activeCpuTicks / stats.totalCpuTicks * 100.0 : 0;
+}
 
-    // Placeholders
-    stats.idleCpuTicks = 0;
-    stats.activeCpuTicks = 0;
-    stats.totalCpuTicks = 0;
-    stats.pagedIn = 0;
-    stats.pagedOut = 0;
+inline void printVMStat(memoryAllocator::MemoryAllocator &allocator, std::deque<cpucore::Core> &cores, const cpucore::Ticks &scheduler) {
+    VMStat stats = collectVMStat(allocator, cores, scheduler);
 
     // Print like vmstat -s
     std::cout << stats.totalMemory / 1024 << " K total memory\n";
@@ -64,9 +99,37 @@ inline void printVMStat(memoryAllocator::MemoryAllocator &allocator) {
     std::cout << stats.freeMemory / 1024  << " K free memory\n";
     std::cout << stats.idleCpuTicks       << " idle cpu ticks\n";
     std::cout << stats.activeCpuTicks     << " active cpu ticks\n";
+    std::cout << stats.switchCpuTicks     << " context switch cpu ticks\n";
+    std::cout << stats.sleepCpuTicks      << " sleep wait cpu ticks\n";
     std::cout << stats.totalCpuTicks      << " total cpu ticks\n";
+    std::cout << CpuUtilization(stats)    << " % cpu utilization\n";
+    for (auto &c : cores)
+        std::cout << c.ticks.Utilization() << " % cpu utilization (core " << c.id << ")\n";
+    if (scheduler.Total() > 0)
+        std::cout << scheduler.Utilization() << " % cpu utilization (rr scheduler)\n";
     std::cout << stats.pagedIn            << " pages paged in\n";
     std::cout << stats.pagedOut           << " pages paged out\n";
+    std::cout << stats.contextSwitches    << " CPU context switches\n";
+    std::cout << allocator.compactions    << " memory compactions\n";
+    std::cout << allocator.framesMoved    << " frames moved by compaction\n";
+    std::cout << processPool::Shared().liveBytes / 1024 << " K pooled process memory in use\n";
+    std::cout << processPool::Shared().slabBytes / 1024 << " K pooled process memory reserved\n";
+
+    pageReplacement::ReplacementPolicy &policy = *allocator.policy;
+    std::cout << policy.hits              << " page hits (" << policy.Name() << ")\n";
+    std::cout << policy.faults            << " page faults (" << policy.Name() << ")\n";
+    std::cout << policy.evictions         << " pages evicted (" << policy.Name() << ")\n";
+    std::cout << policy.HitRate()         << " % page hit rate (" << policy.Name() << ")\n";
+
+    uint64_t tlbHits = 0, tlbMisses = 0, tlbFlushes = 0;
+    for (auto &c : cores) {
+        tlbHits += c.tlb.hits.load(std::memory_order_relaxed);
+        tlbMisses += c.tlb.misses.load(std::memory_order_relaxed);
+        tlbFlushes += c.tlb.flushes.load(std::memory_order_relaxed);
+    }
+    std::cout << tlbHits                  << " tlb hits\n";
+    std::cout << tlbMisses                << " tlb misses\n";
+    std::cout << tlbFlushes               << " tlb flushes\n";
 }
 
 namespace console{
@@ -76,10 +139,12 @@ namespace console{
             bool exit = false;
             bool mainConsole = false;   //just a flag that this is the main console.      
             Console* handoff = NULL;    //something that tells the main program what console to switch to
+            memoryAllocator::MemoryAllocator* memory = NULL; //set by the core running this console so READ/WRITE can translate addresses
+            cpucore::Core* cpu = NULL;  //core currently running this console, its TLB is used for translation
 
             virtual void drawHeader(){
-                char time[30];
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &process.timestamp);
+                char time[32];
+                wallClock::Format(time, sizeof(time), process.arrivalTime ? process.arrivalTime : process.startTime, wallClock::Listing);
                 cout << "      __   __   __   __   __   __   __" << endl;
                 cout << "---|__|-|__|-|__|-|__|-|__|-|__|-|__|---" << endl;
                 cout << process.pname << endl;
@@ -104,7 +169,7 @@ namespace console{
             }
             void printLog(){
                 if(!process.log.empty()){
-                    for(string s : process.log){
+                    for(auto& s : process.log){
                         cout << s;
                     }
                 }       
@@ -121,16 +186,24 @@ namespace console{
             Console(Process p): process(p){} //For consoles for processes       
 
             void clear(){
-                system("cls");
+                terminalScreen::Clear();
                 drawHeader();
                 printProcesses();
             }
         private:
+            //Hex address like 0x1F0, -1 if it isn't one.
+            static int virtualAddress(const char* addr){
+                char* end = NULL;
+                long vaddr = strtol(addr, &end, 16);
+                if(end == addr || *end != '\0' || vaddr < 0 || vaddr > INT_MAX) return -1;
+                return (int)vaddr;
+            }
+
             void cmdHelp(){
                 cout << "For more information on a specific command, type it out (i.e. type only 'screen' and enter)" << endl;
                 cout << left << setw(15) << "clear" << setw(10) << "" << "Clear the screen while leaving the header." << endl;
                 cout << left << setw(15) << "exit" << setw(10) << "" << "Exit the program." << endl;
-                cout << left << setw(15) << "process-smi" << setw(10) << "" << "Prints the information of the process and the logs." << endl;
+                cout << left << setw(15) << "process-smi" << setw(10) << "" << "Prints CPU, memory and per-core usage. process-smi -w <ms> keeps it on screen, refreshing in place until Enter." << endl;
                 cout << left << setw(15) << "PRINT" << setw(10) << "" << "Displays an output message to the console." << endl;
                 cout << left << setw(15) << "DECLARE" << setw(10) << "" << "Declare a uint16 variable." << endl;
                 cout << left << setw(15) << "ADD" << setw(10) << "" << "Add two values or variables and store the sum in a variable." << endl;
@@ -179,52 +252,126 @@ namespace console{
 
     };
 
+    // Process consoles come from the shared size-class pool, so the nodes of finished ones get reused by new ones.
+    using ConsoleList = list<Console, processPool::PoolAllocator<Console>>;
+    using ConsoleVector = vector<Console, processPool::PoolAllocator<Console>>;
+
     class MainConsole : public Console{
         public:
             // Queues and flags
-            list<Console> processQueue;
-            vector<Console> runningProcesses;
-            vector<Console> finishedProcesses;
+            ConsoleList processQueue;           //Change with enqueue/dequeue so readyRows follows along
+            ConsoleVector runningProcesses;
+            processTable::RowLog readyRows;     //Row per processQueue entry, same order. Guarded by queueMutex
+            processTable::RowLog finishedRows;  //Newest finishedRetention finished processes, older ones are in archive. Guarded by processStatusMutex
+            size_t finishedRetention = 1000;    //finished-retention in config.txt, 0 keeps everything in memory
+            processArchive::Archive archive;    //Append-only summaries of finished processes that left the window
+            string archivePath = "csopesy-archive.txt";
+            string filePrefix;                  //in front of every file written without a name given (archive, snapshots, report-util), see newMainConsole
+            processIndex::ProcessIndex processes; //name/pid -> state and a stable console for screen -r
+            std::shared_ptr<Console> attached;    //console screen -r switched to, kept alive while the UI points at it
+            latency::Recorder latencies;          //wait/response/turnaround/admission histograms, one set per core + one for rrscheduler
+            trace::Tracer tracer;                 //scheduler events for trace start|stop|dump, one ring per core + rrscheduler + generator
+
+            // Stamp a state transition the first time it happens and record how long after arrival it was.
+            // slot is the core id, numCPU for the round robin scheduler thread.
+            void stamp(Process& p, latency::Metric metric, int slot){
+                uint64_t& when = (metric == latency::Admission) ? p.admitNs : (metric == latency::Wait) ? p.startNs
+                               : (metric == latency::Response) ? p.responseNs : p.finishNs;
+                if (when != 0) return;
+                when = latency::NowNs();
+                if (p.arrivalNs != 0) latencies.Record(slot, metric, when - p.arrivalNs);
+                if (metric == latency::Turnaround){
+                    lastFinishNs.store(when, std::memory_order_relaxed);
+                    lastFinishTick.store(virtualTick(), std::memory_order_relaxed);
+                }
+            }
+            std::atomic<uint64_t> lastFinishNs{0};   //when the latest process finished, for the batch summary's makespan
+            std::atomic<uint64_t> lastFinishTick{0}; //the same in virtual time (see virtualTick)
             vector<thread> cores;
+            std::deque<cpucore::Core> coreStates; //TLB, counters and other per-core state, one per entry in cores. deque since Core holds atomics.
+            cpucore::Ticks schedulerTicks;        //rrscheduler runs processes itself, these are its ticks. Only rrscheduler writes them
 
-            mutex queueMutex;
-            mutex processStatusMutex;
-            condition_variable cv;
+            // Every lock on these goes through lockStat::Lock with the name of the call site, see lockstat.
+            lockStat::ProfiledMutex queueMutex{"queueMutex"};
+            lockStat::ProfiledMutex processStatusMutex{"processStatusMutex"};
+            std::condition_variable_any cv;
 
             int numCPU;
             string scheduler;
-            int quantumCycles;
-            int batchProcessFreq;
-            int minIns;
-            int maxIns;
-            int delayPerExec;
 
             int maxOverallMem;
             int memPerFrame;
-            int minMemPerProc;
-            int maxMemPerProc;
+
+            // quantum-cycles, delays-per-exec, batch-process-freq and the process size ranges, changed live by config set
+            // and config reload. Snapshots are never freed, so one a core is still using stays valid after the next is published.
+            const Tunables& tunables() const { return *currentTunables.load(std::memory_order_acquire); }
+            void publishTunables(Tunables t){
+                std::lock_guard<std::mutex> lock(configMutex);
+                const Tunables* current = currentTunables.load(std::memory_order_relaxed);
+                t.version = current ? current->version + 1 : 1;
+                publishedTunables.emplace_back(new Tunables(t));
+                currentTunables.store(publishedTunables.back().get(), std::memory_order_release);
+            }
+            std::atomic<const Tunables*> currentTunables{nullptr};
+            vector<std::unique_ptr<const Tunables>> publishedTunables; //Guarded by configMutex
+            std::mutex configMutex;             //Serializes config set/reload, readers never take it
+            Config config{};                    //What the console was started with plus every live change since. Only the input thread touches it
+            string configPath = "config.txt";   //Where config reload reads from
 
             int numFrames;
+            bool tlbAsidTagged = false; //tlb-mode in config.txt: "asid" keeps entries across context switches, "flush" drops them
             
-            bool running = true;
+            std::atomic<bool> running{true};    //cleared by shutdown(), every thread below checks it
             void handleProcessCalls(string s);
+            void shutdown();
             void printProcesses();
-            void _printProcesses(list<Console> list);
-            void _printProcesses(vector<Console> list, bool withCore);
-            void printProcessesToFile();
+            void retireFinished();
+            processTable::Snapshot snapshotProcesses();
+            void writeProcessReport(std::ostream& out, processTable::Snapshot& snap);
+
+            // processQueue and readyRows change together. Call with queueMutex held.
+            // slot is whose trace ring the enqueue goes in: the core id, numCPU for rrscheduler, numCPU + 1 for the generator.
+            void enqueue(const Console& c, int slot){
+                tracer.Emit(slot, trace::Enqueue, c.process.pid);
+                processQueue.push_back(c);
+                readyRows.Push(processTable::RowOf(processQueue.back().process, memManager.memoryPerFrame));
+                readyCount.store(readyRows.Size(), std::memory_order_relaxed);
+            }
+            Console dequeue(){
+                Console c = processQueue.front();
+                processQueue.pop_front();
+                readyRows.Pop();
+                readyCount.store(readyRows.Size(), std::memory_order_relaxed);
+                return c;
+            }
+            std::atomic<uint64_t> readyCount{0};     //processQueue size, for readers that can't take queueMutex (metrics export)
+            std::atomic<uint64_t> finishedCount{0};  //processes finished since start, same
+            string prometheusMetrics();
+            void printProcessesToFile(processTable::Format format = processTable::Text, string filename = "");
 
             void printProcessSMI();
+            void watchProcessSMI(int intervalMs);
             
             int consoleMade = 0;
 
 
             std::atomic<bool> generatingProcesses{false};
             std::thread processGeneratorThread;
+            workload::Recorder workloadLog;         //workload record: every process the generator makes, with its arrival tick
+            vector<workload::Spec> replaySpecs;     //workload replay: what the generator makes instead of random processes
+            std::atomic<bool> replaying{false};
+            // Ticks for workload record/replay and the batch makespan: the busiest core's count, so it advances at the same
+            // rate whatever num-cpu is. With clock.SetVirtual (--sweep) nothing sleeps and this is the only time there is.
+            virtualClock::Clock clock;
+            uint64_t virtualTick(){ return clock.Now(); }
             void startProcessGenerator(int i = 0, string s = "", int mem = 16);
             void stopProcessGenerator();
             void processGeneratorLoop(int i = 0, string s = "", int mem = 16);
+            bool waitForTick(uint64_t tick);
 
             memoryAllocator::MemoryAllocator memManager;
+            snapshotStream::SnapshotWriter snapshots; //memory map per quantum, enabled by memory-snapshots in config.txt
+            metricsExport::Exporter exporter;         //metrics-export, declared after what it reads so it stops first
             void drawHeader(){
                 cout << "      ______   ______   ______   ______   ______   ______   ______" << endl;
                 cout << "---|______|-|______|-|______|-|______|-|______|-|______|-|______|---" << endl;
@@ -244,8 +391,26 @@ namespace console{
                 drawHeader();
                 printProcesses();
             }
-            MainConsole(int nCpu, string sched, int qc, int bpf, int min, int max, int delay,int maxMem, int memPerFrame, int minmemPerProc, int maxmemPerProc) : numCPU(nCpu), scheduler(sched), quantumCycles(qc), batchProcessFreq(bpf), minIns(min), maxIns(max), delayPerExec(delay), memManager(maxMem, memPerFrame), minMemPerProc(minmemPerProc), maxMemPerProc(maxmemPerProc) {
+            MainConsole(int nCpu, string sched, int qc, int bpf, int min, int max, int delay,int maxMem, int memPerFrame, int minmemPerProc, int maxmemPerProc, string replacementPolicy = "none") : numCPU(nCpu), scheduler(sched), memManager(maxMem, memPerFrame, replacementPolicy) {
                 mainConsole = true;
+                Tunables initial;
+                initial.quantumCycles = qc;
+                initial.batchProcessFreq = bpf;
+                initial.minIns = min;
+                initial.maxIns = max;
+                initial.delayPerExec = delay;
+                initial.minMemPerProc = minmemPerProc;
+                initial.maxMemPerProc = maxmemPerProc;
+                publishTunables(initial);
+                for (int i = 0; i < numCPU; ++i) {
+                    coreStates.emplace_back();
+                    coreStates.back().id = i;
+                    clock.AddSlot(&coreStates.back().ticks);
+                }
+                if (scheduler == "rr") clock.AddSlot(&schedulerTicks); //slot numCPU, rrscheduler runs processes too
+                memManager.SetShards(numCPU); //one free-frame shard per core so admission on different cores doesn't contend
+                latencies.SetSlots(numCPU + 1);
+                tracer.SetSlots(numCPU + 2);
                 // Start CPU cores
                 for (int i = 0; i < numCPU; ++i) {
                     cores.emplace_back(&MainConsole::cpuWorker, this, i);
@@ -257,23 +422,59 @@ namespace console{
 
             // CPU thread function,
             void cpuWorker(int coreId) {
+                cpucore::Core& self = coreStates[coreId];
                 while (running) {
                     Console console;
 
                     {   //This block is the source of cpuWorker yoinking processes before scheduler
-                        std::unique_lock<std::mutex> lock(queueMutex);
-                        cv.wait(lock, [this] { return !processQueue.empty() || !running; });
-                        //if (!running && processQueue.empty()) return;
+                        lockStat::Lock lock(queueMutex, "cpuWorker: dequeue");
+                        if (processQueue.empty()) clock.Park(coreId);
+                        while (processQueue.empty() && running) {
+                            //Nothing to run: every tick spent waiting is an idle tick (in virtual time they're added on Unpark)
+                            if (cv.wait_for(lock, milliseconds(std::max(tunables().delayPerExec, 1))) == std::cv_status::timeout && !clock.Virtual())
+                                self.ticks.idle.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        if (processQueue.empty()) return; //woken by shutdown()
+                        clock.Unpark(coreId);
 
                         // Atomic fetch and pop
-                        console = processQueue.front();
-                        processQueue.pop_front();
+                        console = dequeue();
                     }
 
+                    // Admit into memory from this core's shard. If it doesn't fit yet, give it back to the queue.
+                    if (!console.process.pageTable) {
+                        if (!memManager.Admit(console.process, coreId)) {
+                            tracer.Emit(coreId, trace::AllocFail, console.process.pid);
+                            {
+                                lockStat::Lock lock(queueMutex, "cpuWorker: requeue");
+                                enqueue(console, coreId);
+                            }
+                            cv.notify_one();
+                            self.ticks.idle.fetch_add(1, std::memory_order_relaxed); //waiting on memory counts as idle
+                            clock.Spend(coreId, 1);
+                            continue;
+                        }
+                        tracer.Emit(coreId, trace::AllocSuccess, console.process.pid);
+                        stamp(console.process, latency::Admission, coreId);
+                    }
+                    tracer.Emit(coreId, trace::Dispatch, console.process.pid);
+                    self.busy.store(true, std::memory_order_relaxed);
+                    std::shared_ptr<Console> view = processes.View(console.process.pid);
+
                     {   //I was also trying to replace this 
-                        std::lock_guard<std::mutex> lock(processStatusMutex);
+                        lockStat::Lock lock(processStatusMutex, "cpuWorker: start");
                         console.process.start(coreId);
+                        stamp(console.process, latency::Wait, coreId);
+                        self.asidTagged = tlbAsidTagged;
+                        self.ContextSwitch(console.process.pid);
+                        console.memory = &memManager;
+                        console.cpu = &self;
                         runningProcesses.push_back(console);
+                        self.lines.store(console.process.lineCount, std::memory_order_relaxed);
+                        self.line.store(console.process.currLine, std::memory_order_relaxed);
+                        self.pid.store(console.process.pid, std::memory_order_relaxed);
+                        if (view) view->process = console.process;
+                        processes.SetState(console.process.pid, processIndex::Running);
                     }
 
                     /* I was trying to make this work
@@ -287,27 +488,45 @@ namespace console{
                         
                     }*/
 
+                    // FCFS runs the process to the end, but still takes up config changes every quantum-cycles instructions
+                    const Tunables* quantum = &tunables();
                     for (int i = 0; i < console.process.lineCount; ++i) {
+                        if (!running) return; //shutting down, the process is dropped
+                        if (i > 0 && i % std::max(quantum->quantumCycles, 1) == 0) quantum = &tunables();
+                        bool sleeping = false;
                         {
-                            std::lock_guard<std::mutex> lock(processStatusMutex);
+                            lockStat::Lock lock(processStatusMutex, "cpuWorker: instruction");
 
                             // Update internal `console` state
-                            if(!console.process.commands.empty()) {
+                            if(console.process.HasCommand()) {
+                                const char* cmd = console.process.CurrentCommand();
+                                sleeping = strncmp(cmd, "sleep", 5) == 0 || strncmp(cmd, "SLEEP", 5) == 0;
+                                if (sleeping) tracer.Emit(coreId, trace::Sleep, console.process.pid);
                                 try{
-                                    console.handleInput(console.process.commands.front());
-                                    console.process.commands.pop_front();
+                                    console.handleInput(console.process.CurrentCommand());
+                                    console.process.PopCommand();
                                 }catch(std::exception e){
                                     cout << "error with somethign?? " << e.what() << endl;
                                 };
                             }
                             console.process.currLine += 1;
+                            self.line.store(console.process.currLine, std::memory_order_relaxed);
+                            stamp(console.process, latency::Response, coreId);
+                            if (sleeping) self.ticks.sleepWait.fetch_add(1, std::memory_order_relaxed);
+                            else self.ticks.busy.fetch_add(1, std::memory_order_relaxed);
+                            if (view) {
+                                view->process.currLine = console.process.currLine;
+                                view->process.nextCommand = console.process.nextCommand;
+                                view->process.log.insert(view->process.log.end(), console.process.log.begin() + std::min(view->process.log.size(), console.process.log.size()), console.process.log.end());
+                            }
                             // Also update the copy in runningProcesses
                             for (auto& proc : runningProcesses) {
                                 if (proc.process.core == console.process.core) {
                                     try{
                                         proc.process.currLine = console.process.currLine;
-                                        if(!proc.process.commands.empty()) proc.process.commands.pop_front();
-                                        proc.process.log = console.process.log; // Update log
+                                        proc.process.nextCommand = console.process.nextCommand;
+                                        // Update log, only the lines this instruction added
+                                        proc.process.log.insert(proc.process.log.end(), console.process.log.begin() + std::min(proc.process.log.size(), console.process.log.size()), console.process.log.end());
                                         break;
                                     }catch(std::exception e){
                                         cout << "error with somethign?? " << e.what() << endl;
@@ -316,11 +535,12 @@ namespace console{
                             }
                         }
 
-                        std::this_thread::sleep_for(std::chrono::milliseconds(delayPerExec));
+                        clock.Spend(coreId, quantum->delayPerExec);
+                        if (sleeping) tracer.Emit(coreId, trace::Wake, console.process.pid);
                     }
 
                     {
-                        std::lock_guard<std::mutex> lock(processStatusMutex);
+                        lockStat::Lock lock(processStatusMutex, "cpuWorker: finish");
                         runningProcesses.erase(
                             std::remove_if(runningProcesses.begin(), runningProcesses.end(),
                                 [&](const Console& info) {
@@ -330,18 +550,27 @@ namespace console{
                         );
                         
                         console.process.end();
-                        finishedProcesses.push_back(console);
+                        stamp(console.process, latency::Turnaround, coreId);
+                        tracer.Emit(coreId, trace::Finish, console.process.pid);
+                        finishedRows.Push(processTable::RowOf(console.process, memManager.memoryPerFrame));
+                        finishedCount.fetch_add(1, std::memory_order_relaxed);
+                        if (view) view->process = console.process;
+                        processes.SetState(console.process.pid, processIndex::Finished);
+                        retireFinished();
                     }
+                    memManager.DeallocateProcess(console.process, coreId);
+                    tracer.Emit(coreId, trace::Free, console.process.pid);
+                    self.pid.store(-1, std::memory_order_relaxed);
+                    self.busy.store(false, std::memory_order_relaxed);
                 }
             }
 
             // Scheduler that adds n consoles with processes -- THIS DOES NOT SUPPORT HAVING MORE PROCESSES ADDED
             void FCFSscheduler(int numProcess){   
 
-                //Wait until all processes are scheduled and completed
-                while(true){ //possible error condition
-                    //std::lock_guard<mutex> lock(queueMutex);
-                    //if(processQueue.empty()) break;
+                //Wait until all processes are scheduled and completed. The cores do the scheduling, this only waits for shutdown().
+                while(running){
+                    std::this_thread::sleep_for(milliseconds(10));
                 }
 
                 cv.notify_all();
@@ -352,35 +581,43 @@ namespace console{
         void rrscheduler(int numProcess) {
             quantumCounter = 0;
 
-            while (true) {
+            while (running) {
                 Console current;
 
                 {
-                    std::unique_lock<std::mutex> lock(queueMutex);
-                    cv.wait(lock, [&] { return !processQueue.empty(); });
+                    lockStat::Lock lock(queueMutex, "rrscheduler: dequeue");
+                    if (processQueue.empty()) clock.Park(numCPU);
+                    cv.wait(lock, [&] { return !processQueue.empty() || !running; });
+                    if (processQueue.empty()) break; //woken by shutdown()
+                    clock.Unpark(numCPU);
                     //cout << "Got process" << endl;
-                    current = processQueue.front();
-                    processQueue.pop_front();
+                    current = dequeue();
                 }
             
                 // If not allocated memory yet, try allocating
-                if (current.process.frames.empty()) {
+                if (!current.process.pageTable) {
                     //cout << "allocating!!" << endl;
-                    bool success = memManager.AllocateProcess(current.process);
+                    bool success = memManager.Admit(current.process);
                     if (!success) {
                         // Not enough memory; send back to end of queue
                         // cout << "not success" << endl;
-                        std::lock_guard<std::mutex> lock(queueMutex);
-                        processQueue.push_back(current);
+                        tracer.Emit(numCPU, trace::AllocFail, current.process.pid);
+                        schedulerTicks.idle.fetch_add(1, std::memory_order_relaxed); //waiting on memory counts as idle
+                        {
+                            lockStat::Lock lock(queueMutex, "rrscheduler: requeue");
+                            enqueue(current, numCPU);
+                        }
                         cv.notify_one();
-                        std::this_thread::sleep_for(milliseconds(1));
+                        clock.Spend(numCPU, 1); //not under queueMutex, in virtual time this can wait on the generator
                         continue;
                     }
+                    tracer.Emit(numCPU, trace::AllocSuccess, current.process.pid);
+                    stamp(current.process, latency::Admission, numCPU);
                     //update the memory management
                     for (auto& proc : runningProcesses) {
                                 if (proc.process.core == current.process.core) {
                                     try{
-                                        proc.process.frames = current.process.frames;
+                                        proc.process.pageTable = current.process.pageTable;
                                         proc.process.size = current.process.size;
                                         break;
                                     }catch(std::exception e){
@@ -391,44 +628,74 @@ namespace console{
                     cout << "allocated!" << endl;
                 }
                 
-                // Simulate execution for up to `quantumCycles`
+                // Simulate execution for up to `quantumCycles`, as configured when the quantum started
+                const Tunables& quantum = tunables();
+                stamp(current.process, latency::Wait, numCPU);
+                tracer.Emit(numCPU, trace::Dispatch, current.process.pid);
                 int execCount = 0;
-                while (execCount < quantumCycles && current.process.currLine < current.process.lineCount) {
-                    std::this_thread::sleep_for(milliseconds(delayPerExec));
+                while (execCount < quantum.quantumCycles && current.process.currLine < current.process.lineCount) {
+                    memManager.AccessAddress(current.process, current.process.InstructionAddress()); //instruction fetch, may fault the page back in
                     current.process.incrementLine();
+                    schedulerTicks.busy.fetch_add(1, std::memory_order_relaxed);
+                    clock.Spend(numCPU, quantum.delayPerExec);
+                    stamp(current.process, latency::Response, numCPU);
                     execCount++;
                 }
                 quantumCounter++;
+                memManager.Tick();
+                {
+                    lockStat::Lock lock(processStatusMutex, "rrscheduler: quantum");
+                    std::shared_ptr<Console> view = processes.View(current.process.pid);
+                    if (view) {
+                        view->process.currLine = current.process.currLine;
+                        view->process.pageTable = current.process.pageTable;
+                        view->process.size = current.process.size;
+                    }
+                }
 
-                // Take snapshot
-                //memoryAllocator::writeMemorySnapshot(quantumCounter, memManager.frames, memManager.memoryPerFrame);
+                // Take snapshot (queued for the background writer, see snapshotStream.h)
+                snapshots.Capture(quantumCounter, memManager);
                 //std::cout << "RAH " << current.process.pid << std::endl;
                 // If done, deallocate memory
                 if (current.process.currLine >= current.process.lineCount) {
                     //std::cout << "maybe. " << current.process.pid << std::endl;
                     current.process.end();
+                    stamp(current.process, latency::Turnaround, numCPU);
+                    tracer.Emit(numCPU, trace::Finish, current.process.pid);
+                    {
+                        lockStat::Lock lock(processStatusMutex, "rrscheduler: finish");
+                        std::shared_ptr<Console> view = processes.View(current.process.pid);
+                        finishedRows.Push(processTable::RowOf(current.process, memManager.memoryPerFrame));
+                        finishedCount.fetch_add(1, std::memory_order_relaxed);
+                        if (view) view->process = current.process;
+                        processes.SetState(current.process.pid, processIndex::Finished);
+                        retireFinished();
+                    }
                     //std::cout << "yes." << std::endl;
                     memManager.DeallocateProcess(current.process);
+                    tracer.Emit(numCPU, trace::Free, current.process.pid);
                     //std::cout << "no." << std::endl;
                 } else {
                     //std::cout << "HUH!ASDADWD " << current.process.pid << std::endl;
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    processQueue.push_back(current);
+                    tracer.Emit(numCPU, trace::Preempt, current.process.pid);
+                    lockStat::Lock lock(queueMutex, "rrscheduler: preempt");
+                    enqueue(current, numCPU);
                     cv.notify_one();
                 }
                 //std::cout << "meow " << current.process.pid << std::endl;
 
                 // Exit condition: nothing in queue and memory is empty
                 {
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    bool memoryEmpty = std::all_of(memManager.frames.begin(), memManager.frames.end(), [](const Frame& f) {
-                        return f.pid.empty();
-                    });
+                    lockStat::Lock lock(queueMutex, "rrscheduler: exit check");
+                    bool memoryEmpty = memManager.UsedFrames() == 0;
 
-                    if (processQueue.empty() && memoryEmpty) break;
+                    if (processQueue.empty() && memoryEmpty){
+                        clock.Park(numCPU);
+                        break;
+                    }
                 }
 
-                std::this_thread::sleep_for(milliseconds(1));
+                if (!clock.Virtual()) std::this_thread::sleep_for(milliseconds(1));
             }
 
             cv.notify_all();
@@ -444,7 +711,14 @@ namespace console{
                 cout << setw(15) << "screen" << setw(10) << "" << "Start or open a console for a process." << endl;
                 cout << setw(15) << "scheduler-test" << setw(10) << "" << "Every x cpu ticks (defined in config.txt), a new process is generated and put in the ready Queue." << endl;
                 cout << setw(15) << "scheduler-stop" << setw(10) << "" << "Stops the scheduler-test command." << endl;
-                cout << setw(15) << "report-util" << setw(10) << "" << "Prints a summary of CPU utilization and processes to a text file." << endl;
+                cout << setw(15) << "report-util" << setw(10) << "" << "Prints a summary of CPU utilization and processes to a file. usage: report-util [--format csv|jsonl|text] [file]" << endl;
+                cout << setw(15) << "latency" << setw(10) << "" << "Prints p50/p90/p99/p999 of queue wait, first response, turnaround and admission latency." << endl;
+                cout << setw(15) << "trace" << setw(10) << "" << "Records scheduler events (enqueue, dispatch, preempt, sleep, alloc, free, finish). usage: trace start|stop|dump <file>" << endl;
+                cout << setw(15) << "lockstat" << setw(10) << "" << "Acquisitions, contention, wait and hold time of queueMutex and processStatusMutex per call site. usage: lockstat [reset]" << endl;
+                cout << setw(15) << "workload" << setw(10) << "" << "Records generated processes to a binary trace, or replays one in virtual time. usage: workload record <file> | replay <file> | stop" << endl;
+                cout << setw(15) << "metrics-export" << setw(10) << "" << "Exports counters in Prometheus format. usage: metrics-export http <port> | unix <path> | file <path> [interval ms] | stop" << endl;
+                cout << setw(15) << "config" << setw(10) << "" << "Shows or changes quantum-cycles, delays-per-exec, batch-process-freq, min/max-ins and min/max-mem-per-proc while running. usage: config [set <key> <value> | reload]" << endl;
+                cout << setw(15) << "snapshot-read" << setw(10) << "" << "Rebuilds the memory map at a quantum from the snapshot stream. usage: snapshot-read <quantum> [file]" << endl;
             }
 
             void cmdScreenHelp(){
@@ -470,330 +744,331 @@ namespace console{
                 cv.notify_one();
                 */
             }
-            Console* searchList(string name){ //used to search through the console list
-                for(Console &c : processQueue){
-                    if(c.process.pname == name) return &c; //If it finds a matching process name, return the address of the console
+            Console* searchList(string name){ //used to find the console for screen -r, by process name or pid
+                processIndex::Entry entry;
+                bool found = processes.FindByName(name, entry);
+                if(!found && !name.empty() && name.find_first_not_of("0123456789") == string::npos){
+                    long pid = strtol(name.c_str(), NULL, 10); //LONG_MAX if it overflows, which no pid is
+                    if(pid <= INT_MAX) found = processes.FindByPid((int)pid, entry);
                 }
-                for(Console &c : runningProcesses){
-                    if(c.process.pname == name) return &c; //If it finds a matching process name, return the address of the console
+                if(!found){
+                    cout << "[SearchList] could not find process name \"" << name << "\"" << endl;
+                    return NULL;
                 }
-                for(Console &c : finishedProcesses){
-                    if(c.process.pname == name) return &c; //If it finds a matching process name, return the address of the console
+                if(!entry.view){
+                    cout << "Process " << entry.pname << " (pid " << entry.pid << ") " << processIndex::StateName(entry.state) << ", see " << archivePath << endl;
+                    return NULL;
                 }
-                cout << "[SearchList] could not find process name \"" << name << "\"" << endl;
-                return NULL;
+                attached = entry.view; //the UI holds a raw pointer, so pin it until the next screen -r
+                return attached.get();
             }
     };
 
-    void MainConsole::_printProcesses(list<Console> list){ //just a helper function for printing processes
-        char time[30];
-        char timeS[30];
-        char timeF[30];
-        int percentage;
-        cout << left << setw(4) << "PID";
-        cout << left << "\t" << setw(20) << "Name";
-        cout << left << "\t" << setw(30) << "Time arrived";
-        cout << left << "\t" << setw(30) << "Time started";
-        cout << left << "\t" << setw(30) << "Time finished";
-        cout << left << "\t" << setw(15) << "Current Line";
-        cout << left << "\t" << setw(15) << "Total Lines";
-        cout << left << "\t" << setw(17) << "Progress" << endl;
-
-        if(!list.empty()){
-            for(Console c : list){
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &c.process.arrivalTimeStamp);
-                strftime(timeS, sizeof(timeS), "%m/%d/%Y, %I:%M:%S %p", &c.process.timestamp);
-                strftime(timeF, sizeof(timeF), "%m/%d/%Y, %I:%M:%S %p", &c.process.finishTimeStamp);
-                percentage = ((double)c.process.currLine / (double)c.process.lineCount) * 100.00;
-
-                cout << left << setw(4) << c.process.pid;
-                cout << left << "\t" << setw(20) << c.process.pname;
-                cout << left << "\t" << setw(30) << time;
-                cout << left << "\t" << setw(30) << timeS;
-                cout << left << "\t" << setw(30) << timeF;
-                cout << left << "\t" << setw(15) << c.process.currLine;
-                cout << left << "\t" << setw(15) << c.process.lineCount;
-                cout << right << "\t" << setw(3) << percentage;
-                cout << left << "% [";
-                for(int i = 0; i < percentage / 10; i++){
-                    cout << "#";
-                }
-                for(int i = percentage / 10; i < 9; i++){
-                    cout << "-";
-                }   
-                cout << "]" << endl;
-            }
+    // Keeps only the newest finishedRetention finished processes in memory. Older ones are appended to the archive and
+    // their screen -r console is dropped. If the archive couldn't be opened at startup everything stays in memory.
+    // Call with processStatusMutex held.
+    void MainConsole::retireFinished(){
+        if(finishedRetention == 0 || !archive.IsOpen()) return;
+        while(finishedRows.Size() > finishedRetention){
+            archive.Append(finishedRows.Front());
+            processes.Archive(finishedRows.Front().pid);
+            finishedRows.Pop();
         }
-        else{
-            cout << "No processes to be listed." << endl;
+    }
+
+    // Stops the generator and the cores and waits for them (instead of detaching them at exit). Processes still
+    // queued or mid-run are dropped. The scheduler thread is owned by main, which joins it after this.
+    void MainConsole::shutdown(){
+        generatingProcesses = false;
+        if (processGeneratorThread.joinable()) processGeneratorThread.join();
+        {
+            //Under queueMutex so a thread between checking its wait predicate and blocking can't miss the wakeup
+            lockStat::Lock lock(queueMutex, "shutdown");
+            running = false;
+        }
+        clock.Release();
+        cv.notify_all();
+        for (auto& t : cores) {
+            if (t.joinable()) t.join();
         }
-        cout << endl << endl;
+        exporter.Stop();
     }
 
-    void MainConsole::_printProcesses(vector<Console> list, bool withCore = false){
-        char time[30];
-        char timeS[30];
-        char timeF[30];
-        int percentage;
-        cout << left << setw(4) << "PID";
-        cout << left << "\t" << setw(20) << "Name";
-        cout << left << "\t" << setw(30) << "Time arrived";
-        cout << left << "\t" << setw(30) << "Time started";
-        if(!withCore)
-            cout << left << "\t" << setw(30) << "Time finished";
-        else
-            cout << left << "\t" << setw(8) << "Core";
-        cout << left << "\t" << setw(15) << "Current Line";
-        cout << left << "\t" << setw(15) << "Total Lines";
-        cout << left << "\t" << setw(17) << "Progress";
-        if(withCore)
-            cout << left << "\t" << setw(15) << "Memory Utilization" << endl;
-        else
-            cout << endl;
-
-        if(!list.empty()){
-            for(Console c : list){
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &c.process.arrivalTimeStamp);
-                strftime(timeS, sizeof(timeS), "%m/%d/%Y, %I:%M:%S %p", &c.process.timestamp);
-                strftime(timeF, sizeof(timeF), "%m/%d/%Y, %I:%M:%S %p", &c.process.finishTimeStamp);
-                percentage = ((double)c.process.currLine / (double)c.process.lineCount) * 100.00;
-
-                cout << left << setw(4) << c.process.pid;
-                cout << left << "\t" << setw(20) << c.process.pname;
-                cout << left << "\t" << setw(30) << time;
-                cout << left << "\t" << setw(30) << timeS;
-                if(!withCore)
-                    cout << left << "\t" << setw(30) << timeF;
-                else
-                    cout << left << "\t" << setw(8) << c.process.core;
-                cout << left << "\t" << setw(15) << c.process.currLine;
-                cout << left << "\t" << setw(15) << c.process.lineCount;
-                cout << right << "\t" << setw(3) << percentage;
-                cout << left << "% [";
-                for(int i = 0; i < percentage / 10; i++){
-                    cout << "#";
-                }
-                for(int i = percentage / 10; i < 9; i++){
-                    cout << "-";
-                }   
-                cout << "]     ";
-
-                if(withCore)
-                    cout << left << setw(15) << c.process.getMemorySize() * memPerFrame << endl;
-                else 
-                    cout << endl;
-            }
+    // Implementation for continuous process generation
+    void MainConsole::startProcessGenerator(int i, string s, int mem) {
+        if (generatingProcesses) {
+            std::cout << "Process generator already running.\n";
+            return;
         }
-        else{
-            cout << "No processes to be listed." << endl;
+        generatingProcesses = true;
+        processGeneratorThread = std::thread(&MainConsole::processGeneratorLoop, this, i, s, mem);
+        std::cout << "[scheduler -start] Process generator started.\n";
+    }
+
+    void MainConsole::stopProcessGenerator() {
+        if (!generatingProcesses) {
+            std::cout << "Process generator is not running.\n";
+            return;
+        }
+        generatingProcesses = false;
+        if (processGeneratorThread.joinable()) {
+            processGeneratorThread.join();
         }
-        cout << endl << endl;
+        std::cout << "[scheduler -stop] Process generator stopped.\n";
     }
 
-    void MainConsole::printProcesses(){
-        char refreshTime[30];
-        time_t refresh;
-        struct tm timestamp;
-        time(&refresh); //Log when the process was started
-        localtime_s(&timestamp, &refresh); //Turn epoch time to calendar time
+    void MainConsole::processGeneratorLoop(int i, string s, int mem) {
+        int numLoops = 0;
+        size_t replayed = 0;
+        uint64_t nextTick = virtualTick();
+        while (generatingProcesses && (numLoops < i || i == 0)) {
+            // Replay: the next recorded process arrives when the cores have done as many ticks as when it was recorded
+            if (replaying) {
+                if (replayed == replaySpecs.size()) break;
+                nextTick = replaySpecs[replayed].tick;
+            }
+            // In virtual time every arrival waits for its tick, batch-process-freq ticks apart when generating
+            if (replaying || clock.Virtual()) {
+                if (!waitForTick(nextTick)) break;
+            }
+            Console console;
+            consoleMade++;
+            uint64_t arrivalTick = clock.Virtual() ? nextTick : virtualTick();
+            const Tunables& settings = tunables();
+            if(replaying){
+                const workload::Spec& spec = replaySpecs[replayed++];
+                console.process = Process(spec.seed, spec.name, consoleMade, spec.lines, spec.memory);
+            }
+            else if(i != 0)
+                console.process = Process(s, consoleMade, settings.minIns, settings.maxIns, mem);
+            else
+                console.process = Process("process_" + std::to_string(consoleMade), consoleMade, settings.minIns, settings.maxIns, settings.minMemPerProc, settings.maxMemPerProc);
+            if (workloadLog.IsOpen()) {
+                workload::Spec spec;
+                spec.tick = arrivalTick;
+                spec.seed = console.process.seed;
+                spec.memory = console.process.size;
+                spec.lines = console.process.lineCount;
+                spec.name = console.process.pname;
+                workloadLog.Append(spec);
+            }
+            processes.Add(consoleMade, console.process.pname, std::allocate_shared<Console>(processPool::PoolAllocator<Console>(), console));
+            {
+                lockStat::Lock lock(queueMutex, "generator: enqueue");
+                enqueue(console, numCPU + 1);
+                //if(i != 0) this->handoff = &processQueue.back();
+            }
+            cv.notify_one();
+            if(i != 0) numLoops++;
+            //if(numLoops >= i && i != 0){
+            //    generatingProcesses = false;
+            //}
+
+            if (replaying) continue;
+            if (clock.Virtual()) nextTick = arrivalTick + std::max(settings.batchProcessFreq, 1);
+            else std::this_thread::sleep_for(milliseconds(settings.batchProcessFreq));
+        }
+        clock.HoldAt(virtualClock::Clock::never);
+        replaying = false;
+    }
 
-        int numCores = cores.size();
-        int usedCores = runningProcesses.size(); //This should be a safe assumption that each running process represents a core being used
+    // Blocks the generator until virtual time reaches tick. In virtual time the cores are held there until the process
+    // arriving at it is queued, and if none of them has anything to do time skips straight to it. False if the generator
+    // was stopped meanwhile.
+    bool MainConsole::waitForTick(uint64_t tick) {
+        clock.HoldAt(tick);
+        while (generatingProcesses && virtualTick() < tick) {
+            if (clock.Virtual()) {
+                lockStat::Lock lock(queueMutex, "generator: wait for tick");
+                if (processQueue.empty() && clock.AllParked()) break;
+            }
+            std::this_thread::sleep_for(clock.Virtual() ? std::chrono::microseconds(50) : std::chrono::microseconds(1000));
+        }
+        clock.Arrive(tick);
+        return generatingProcesses;
+    }
 
-        cout << "CPU Utilization: " << ((double)usedCores/(double)numCores) * 100.00  << "%" << endl;
-        cout << "Cores used: " << usedCores << endl;
-        cout << "Cores available: " << numCores - usedCores << endl;
+    // Consistent picture of the process table. Ready and finished rows are O(1) views (see processTable::RowLog), only the
+    // running rows are copied, so the locks are held for O(running) and the report is written after they're released.
+    processTable::Snapshot MainConsole::snapshotProcesses(){
+        processTable::Snapshot snap;
+        lockStat::Lock queueLock(queueMutex, "snapshotProcesses");          //always this order, nothing else holds both
+        lockStat::Lock statusLock(processStatusMutex, "snapshotProcesses");
+        snap.ready = readyRows.Snapshot();
+        snap.running.reserve(runningProcesses.size());
+        for(Console& c : runningProcesses){
+            snap.running.push_back(processTable::RowOf(c.process, memManager.memoryPerFrame));
+        }
+        snap.finished = finishedRows.Snapshot();
+        snap.archived = archive.archived;
+        for(auto& c : coreStates) snap.coreUtilization.push_back(c.ticks.Utilization());
+        snap.utilization = CpuUtilization(collectVMStat(memManager, coreStates, schedulerTicks));
+        if(snap.archived > 0) archive.Flush();
+        time(&snap.taken);
+        return snap;
+    }
 
-        strftime(refreshTime, sizeof(refreshTime), "%m/%d/%Y, %I:%M:%S %p", &timestamp);
-        cout << "List generated on: " << refreshTime << endl;
-        cout << "===========================================================" << endl;
-        cout << "Processes ready" << endl;
-        _printProcesses(processQueue);
+    // Shared by screen -ls and report-util.
+    void MainConsole::writeProcessReport(std::ostream& out, processTable::Snapshot& snap){
+        char refreshTime[32];
 
-        cout << "Running processes" << endl;
-        _printProcesses(runningProcesses, true);
+        int numCores = cores.size();
+        int usedCores = snap.running.size(); //This should be a safe assumption that each running process represents a core being used
 
-        cout << "Finished processes" << endl;
-        _printProcesses(finishedProcesses);
-        cout << "===========================================================" << endl;
+        out << "CPU Utilization: " << snap.utilization << "%" << "\n"; //busy share of every core tick so far, not just this instant
+        for(size_t i = 0; i < snap.coreUtilization.size(); i++){
+            out << "  Core " << i << ": " << snap.coreUtilization[i] << "%" << "\n";
+        }
+        out << "Cores used: " << usedCores << "\n";
+        out << "Cores available: " << numCores - usedCores << "\n";
+
+        wallClock::Format(refreshTime, sizeof(refreshTime), snap.taken, wallClock::Listing);
+        out << "List generated on: " << refreshTime << "\n";
+        out << "===========================================================" << "\n";
+        out << "Processes ready" << "\n";
+        processTable::WriteTable(out, snap.ready);
+
+        out << "Running processes" << "\n";
+        processTable::WriteTable(out, snap.running, true);
+
+        out << "Finished processes" << "\n";
+        processTable::WriteTable(out, snap.finished);
+        if(snap.archived > 0){
+            out << snap.archived << " older finished processes archived to " << archivePath << "\n" << "\n";
+        }
+        out << "===========================================================" << "\n";
+        latencies.Print(out);
+        out << "===========================================================" << "\n";
+    }
 
+    void MainConsole::printProcesses(){
+        processTable::Snapshot snap = snapshotProcesses();
+        writeProcessReport(cout, snap);
         cout << endl;
 
         cout << "Type \"help\" or \"?\" for a list of commands." << endl << endl;
     }
 
-    void MainConsole::printProcessesToFile(){
-        std::string filename = "csopesy-log.txt";
-
-        // Check if the file is empty
-        std::ifstream infile(filename);
-        bool isEmpty = infile.peek() == std::ifstream::traits_type::eof();
-        infile.close();
-
-        std::ofstream  logFile(filename); //no append, clear the file everytime.
-
-        std::ostringstream newLog;
-
-        //i'm sorry for my sins but i'm just gonna copy whatever printProcesses already does except have it print to oss
-        char refreshTime[30];
-        time_t refresh;
-        struct tm timestamp;
-        time(&refresh); //Log when the process was started
-        localtime_s(&timestamp, &refresh); //Turn epoch time to calendar time
-
-        char time[30];
-        char timeS[30];
-        char timeF[30];
-        int percentage;
-
-        int numCores = cores.size();
-        int usedCores = runningProcesses.size(); //This should be a safe assumption that each running process represents a core being used
-
-        newLog << "CPU Utilization: " << ((double)usedCores/(double)numCores) * 100.00  << "%" << "\n";
-        newLog << "Cores used: " << numCores << endl;
-        newLog << "Cores available: " << usedCores << endl;
-
-        strftime(refreshTime, sizeof(refreshTime), "%m/%d/%Y, %I:%M:%S %p", &timestamp);
-        newLog << "List generated on: " << refreshTime << "\n";
-        newLog << "===========================================================" << "\n";
-        newLog << "Processes ready" << "\n";
-        newLog << left << setw(4) << "PID";
-        newLog << left << "\t" << setw(20) << "Name";
-        newLog << left << "\t" << setw(30) << "Time arrived";
-        newLog << left << "\t" << setw(30) << "Time started";
-        newLog << left << "\t" << setw(30) << "Time finished";
-        newLog << left << "\t" << setw(15) << "Current Line";
-        newLog << left << "\t" << setw(15) << "Total Lines";
-        newLog << left << "\t" << setw(17) << "Progress" << "\n";
-        if(!processQueue.empty()){
-            for(Console c : processQueue){
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &c.process.arrivalTimeStamp);
-                strftime(timeS, sizeof(timeS), "%m/%d/%Y, %I:%M:%S %p", &c.process.timestamp);
-                strftime(timeF, sizeof(timeF), "%m/%d/%Y, %I:%M:%S %p", &c.process.finishTimeStamp);
-                percentage = ((double)c.process.currLine / (double)c.process.lineCount) * 100.00;
-                newLog << left << setw(4) << c.process.pid;
-                newLog << left << "\t" << setw(20) << c.process.pname;
-                newLog << left << "\t" << setw(30) << time;
-                newLog << left << "\t" << setw(30) << timeS;
-                newLog << left << "\t" << setw(30) << timeF;
-                newLog << left << "\t" << setw(15) << c.process.currLine;
-                newLog << left << "\t" << setw(15) << c.process.lineCount;
-                newLog << right << "\t" << setw(3) << percentage;
-                newLog << left << "% [";
-                for(int i = 0; i < percentage / 10; i++){
-                    newLog << "#";
-                }
-                for(int i = percentage / 10; i < 9; i++){
-                    newLog << "-";
-                }   
-                newLog << "]" << "\n";
-            }
-        }
-        else{
-            newLog << "No processes to be listed." << "\n";
-        }
-        newLog << "\n" << "\n";
-
-        newLog << "Running processes" << "\n";
-        newLog << left << setw(4) << "PID";
-        newLog << left << "\t" << setw(20) << "Name";
-        newLog << left << "\t" << setw(30) << "Time arrived";
-        newLog << left << "\t" << setw(30) << "Time started";
-        newLog << left << "\t" << setw(8)  << "Core";
-        newLog << left << "\t" << setw(15) << "Current Line";
-        newLog << left << "\t" << setw(15) << "Total Lines";
-        newLog << left << "\t" << setw(17) << "Progress" << "\n";
-        if(!runningProcesses.empty()){
-            for(Console c : runningProcesses){
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &c.process.arrivalTimeStamp);
-                strftime(timeS, sizeof(timeS), "%m/%d/%Y, %I:%M:%S %p", &c.process.timestamp);
-                strftime(timeF, sizeof(timeF), "%m/%d/%Y, %I:%M:%S %p", &c.process.finishTimeStamp);
-                percentage = ((double)c.process.currLine / (double)c.process.lineCount) * 100.00;
-                newLog << left << setw(4) << c.process.pid;
-                newLog << left << "\t" << setw(20) << c.process.pname;
-                newLog << left << "\t" << setw(30) << time;
-                newLog << left << "\t" << setw(30) << timeS;
-                newLog << left << "\t" << setw(8) << c.process.core;
-                newLog << left << "\t" << setw(15) << c.process.currLine;
-                newLog << left << "\t" << setw(15) << c.process.lineCount;
-                newLog << right << "\t" << setw(3) << percentage;
-                newLog << left << "% [";
-                for(int i = 0; i < percentage / 10; i++){
-                    newLog << "#";
-                }
-                for(int i = percentage / 10; i < 9; i++){
-                    newLog << "-";
-                }   
-                newLog << "]" << "\n";
-            }
-        }
-        else{
-            newLog << "No processes to be listed." << "\n";
+    void MainConsole::printProcessesToFile(processTable::Format format, string filename){
+        if(filename.empty())
+            filename = filePrefix + ((format == processTable::CSV) ? "csopesy-log.csv" : (format == processTable::JSONL) ? "csopesy-log.jsonl" : "csopesy-log.txt");
+        processTable::Snapshot snap = snapshotProcesses();
+
+        thread_local static char buffer[1 << 16]; //sweep runs can write reports at the same time
+        std::ofstream logFile;
+        logFile.rdbuf()->pubsetbuf(buffer, sizeof(buffer)); //rows go out in 64K writes as they're formatted
+        logFile.open(filename, std::ios::trunc); //no append, clear the file everytime.
+        if(!logFile){
+            cout << "Could not open " << filename << endl;
+            return;
         }
-        newLog << "\n" << "\n";
-        newLog << "Finished processes" << "\n";
-        newLog << left << setw(4) << "PID";
-        newLog << left << "\t" << setw(20) << "Name";
-        newLog << left << "\t" << setw(30) << "Time arrived";
-        newLog << left << "\t" << setw(30) << "Time started";
-        newLog << left << "\t" << setw(30) << "Time finished";
-        newLog << left << "\t" << setw(15) << "Current Line";
-        newLog << left << "\t" << setw(15) << "Total Lines";
-        newLog << left << "\t" << setw(17) << "Progress" << "\n";
-        if(!finishedProcesses.empty()){
-            for(Console c : finishedProcesses){
-                strftime(time, sizeof(time), "%m/%d/%Y, %I:%M:%S %p", &c.process.arrivalTimeStamp);
-                strftime(timeS, sizeof(timeS), "%m/%d/%Y, %I:%M:%S %p", &c.process.timestamp);
-                strftime(timeF, sizeof(timeF), "%m/%d/%Y, %I:%M:%S %p", &c.process.finishTimeStamp);
-                percentage = ((double)c.process.currLine / (double)c.process.lineCount) * 100.00;
-                newLog << left << setw(4) << c.process.pid;
-                newLog << left << "\t" << setw(20) << c.process.pname;
-                newLog << left << "\t" << setw(30) << time;
-                newLog << left << "\t" << setw(30) << timeS;
-                newLog << left << "\t" << setw(30) << timeF;
-                newLog << left << "\t" << setw(15) << c.process.currLine;
-                newLog << left << "\t" << setw(15) << c.process.lineCount;
-                newLog << right << "\t" << setw(3) << percentage;
-                newLog << left << "% [";
-                for(int i = 0; i < percentage / 10; i++){
-                    newLog << "#";
-                }
-                for(int i = percentage / 10; i < 9; i++){
-                    newLog << "-";
-                }   
-                newLog << "]" << "\n";
-            }
+        if(format == processTable::Text){
+            writeProcessReport(logFile, snap);
         }
         else{
-            newLog << "No processes to be listed." << "\n";
+            processTable::RowWriter rows(logFile, format);
+            rows.Header();
+            rows.Section("ready", snap.ready);
+            rows.Section("running", snap.running);
+            rows.Section("finished", snap.finished);
         }
-        newLog << "\n" << "\n";
-        newLog << "===========================================================" << "\n";
+        logFile.close();
+        cout << "Report generated! (" << filename << ")" << endl;
 
-        logFile << newLog.str();
-        cout << "Report generated!" << endl;
+    }
 
+    // Prometheus text format for metrics-export. Runs on the exporter thread, so everything here is an atomic counter
+    // (or set once at startup): no queueMutex, no processStatusMutex, no frame table walk.
+    string MainConsole::prometheusMetrics(){
+        string out;
+        char line[256];
+        auto add = [&](const char* fmt, auto... args){
+            snprintf(line, sizeof(line), fmt, args...);
+            out += line;
+        };
+        auto type = [&](const char* name, const char* kind, const char* help){
+            add("# HELP %s %s\n# TYPE %s %s\n", name, help, name, kind);
+        };
+        VMStat stats = collectVMStat(memManager, coreStates, schedulerTicks);
+
+        type("csopesy_ready_queue_depth", "gauge", "Processes waiting in the ready queue.");
+        add("csopesy_ready_queue_depth %llu\n", (unsigned long long)readyCount.load(std::memory_order_relaxed));
+        type("csopesy_running_processes", "gauge", "Cores running a process right now.");
+        add("csopesy_running_processes %llu\n", (unsigned long long)stats.busyCores);
+        type("csopesy_processes_created_total", "counter", "Processes created.");
+        add("csopesy_processes_created_total %llu\n", (unsigned long long)processes.Size());
+        type("csopesy_processes_finished_total", "counter", "Processes that ran to completion.");
+        add("csopesy_processes_finished_total %llu\n", (unsigned long long)finishedCount.load(std::memory_order_relaxed));
+        type("csopesy_config_version", "gauge", "Live config snapshot in use, bumped by config set and config reload.");
+        add("csopesy_config_version %llu\n", (unsigned long long)tunables().version);
+
+        type("csopesy_cpu_ticks_total", "counter", "Core ticks by what the core was doing.");
+        for(auto& c : coreStates){
+            add("csopesy_cpu_ticks_total{core=\"%d\",state=\"busy\"} %llu\n", c.id, (unsigned long long)c.ticks.busy.load(std::memory_order_relaxed));
+            add("csopesy_cpu_ticks_total{core=\"%d\",state=\"idle\"} %llu\n", c.id, (unsigned long long)c.ticks.idle.load(std::memory_order_relaxed));
+            add("csopesy_cpu_ticks_total{core=\"%d\",state=\"switch\"} %llu\n", c.id, (unsigned long long)c.ticks.contextSwitch.load(std::memory_order_relaxed));
+            add("csopesy_cpu_ticks_total{core=\"%d\",state=\"sleep\"} %llu\n", c.id, (unsigned long long)c.ticks.sleepWait.load(std::memory_order_relaxed));
+        }
+        if(schedulerTicks.Total() > 0){ //rr: the scheduler runs processes too
+            add("csopesy_cpu_ticks_total{core=\"rr\",state=\"busy\"} %llu\n", (unsigned long long)schedulerTicks.busy.load(std::memory_order_relaxed));
+            add("csopesy_cpu_ticks_total{core=\"rr\",state=\"idle\"} %llu\n", (unsigned long long)schedulerTicks.idle.load(std::memory_order_relaxed));
+        }
+        type("csopesy_cpu_utilization_percent", "gauge", "Busy share of all ticks since start.");
+        add("csopesy_cpu_utilization_percent %.3f\n", CpuUtilization(stats));
+        for(auto& c : coreStates)
+            add("csopesy_cpu_utilization_percent{core=\"%d\"} %.3f\n", c.id, c.ticks.Utilization());
+        type("csopesy_context_switches_total", "counter", "Times a core switched to a different process.");
+        for(auto& c : coreStates)
+            add("csopesy_context_switches_total{core=\"%d\"} %llu\n", c.id, (unsigned long long)c.contextSwitches.load(std::memory_order_relaxed));
+
+        type("csopesy_memory_bytes", "gauge", "Emulated physical memory.");
+        add("csopesy_memory_bytes{state=\"total\"} %llu\n", (unsigned long long)stats.totalMemory);
+        add("csopesy_memory_bytes{state=\"used\"} %llu\n", (unsigned long long)stats.usedMemory);
+        add("csopesy_memory_bytes{state=\"free\"} %llu\n", (unsigned long long)stats.freeMemory);
+        type("csopesy_pages_paged_in_total", "counter", "Pages brought into memory.");
+        add("csopesy_pages_paged_in_total %llu\n", (unsigned long long)stats.pagedIn);
+        type("csopesy_pages_paged_out_total", "counter", "Pages written out of memory.");
+        add("csopesy_pages_paged_out_total %llu\n", (unsigned long long)stats.pagedOut);
+        pageReplacement::ReplacementPolicy& policy = *memManager.policy;
+        type("csopesy_page_faults_total", "counter", "Accesses that had to bring a page back in.");
+        add("csopesy_page_faults_total{policy=\"%s\"} %llu\n", policy.Name().c_str(), (unsigned long long)policy.faults.load());
+        type("csopesy_page_hits_total", "counter", "Accesses to a resident page.");
+        add("csopesy_page_hits_total{policy=\"%s\"} %llu\n", policy.Name().c_str(), (unsigned long long)policy.hits.load());
+        type("csopesy_page_evictions_total", "counter", "Pages the replacement policy evicted.");
+        add("csopesy_page_evictions_total{policy=\"%s\"} %llu\n", policy.Name().c_str(), (unsigned long long)policy.evictions.load());
+        type("csopesy_compactions_total", "counter", "Compaction passes that moved at least one frame.");
+        add("csopesy_compactions_total %llu\n", (unsigned long long)memManager.compactions.load());
+
+        const char* metricLabels[] = { "queue_wait", "first_response", "turnaround", "admission" };
+        type("csopesy_latency_seconds", "summary", "Time from arrival to each state transition.");
+        for(int m = 0; m < latency::NumMetrics; m++){
+            latency::Summary sum = latencies.Summarize((latency::Metric)m);
+            const char* label = metricLabels[m];
+            add("csopesy_latency_seconds{metric=\"%s\",quantile=\"0.5\"} %.9f\n", label, sum.p50 / 1e9);
+            add("csopesy_latency_seconds{metric=\"%s\",quantile=\"0.9\"} %.9f\n", label, sum.p90 / 1e9);
+            add("csopesy_latency_seconds{metric=\"%s\",quantile=\"0.99\"} %.9f\n", label, sum.p99 / 1e9);
+            add("csopesy_latency_seconds{metric=\"%s\",quantile=\"0.999\"} %.9f\n", label, sum.p999 / 1e9);
+            add("csopesy_latency_seconds_sum{metric=\"%s\"} %.9f\n", label, sum.sum / 1e9);
+            add("csopesy_latency_seconds_count{metric=\"%s\"} %llu\n", label, (unsigned long long)sum.count);
+        }
+        return out;
     }
 
     void MainConsole::printProcessSMI() {
         // Clear screen
-        system("cls");
+        terminalScreen::Clear();
 
         // Print CSOPESY header
         drawHeader();
 
-        // CPU Utilization
-        int numCores = cores.size();
-        int usedCores = runningProcesses.size();
-        double cpuUtil = (numCores > 0) ? ((double)usedCores / numCores) * 100.0 : 0;
+        VMStat stats = collectVMStat(memManager, coreStates, schedulerTicks);
+
+        // CPU Utilization, averaged over every tick so far
+        double cpuUtil = CpuUtilization(stats);
 
         // Memory stats
-        uint64_t totalMemBytes = memManager.maxMemory;
-        uint64_t usedFrames = 0;
-        for (auto &f : memManager.frames) {
-            if (!f.pid.empty()) usedFrames++;
-        }
-        uint64_t usedMemBytes = usedFrames * memManager.memoryPerFrame;
+        uint64_t totalMemBytes = stats.totalMemory;
+        uint64_t usedMemBytes = stats.usedMemory;
         double memUtilPercent = (totalMemBytes > 0) ? ((double)usedMemBytes / totalMemBytes) * 100.0 : 0;
 
         // Convert to MiB
@@ -804,20 +1079,102 @@ namespace console{
         std::cout << "| PROCESS-SMI V01.00 Driver Version: 01.00 |\n";
         std::cout << "-------------------------------------------\n";
         std::cout << "CPU-Util: " << cpuUtil << "%\n";
+        std::cout << "Context switches: " << stats.contextSwitches << "\n";
         std::cout << "Memory Usage: " << usedMiB << "MiB / " << totalMiB << "MiB\n";
-        std::cout << "Memory Util: " << memUtilPercent << "%\n\n";
+        std::cout << "Memory Util: " << memUtilPercent << "%\n";
+        std::cout << "Page policy: " << memManager.policy->Name()
+                  << "  Hits: " << memManager.policy->hits
+                  << "  Faults: " << memManager.policy->faults
+                  << "  Hit rate: " << memManager.policy->HitRate() << "%\n";
+        for (auto &c : coreStates) {
+            std::cout << "Core " << c.id << " Util: " << c.ticks.Utilization() << "%"
+                      << "  TLB  Hits: " << c.tlb.hits.load(std::memory_order_relaxed)
+                      << "  Misses: " << c.tlb.misses.load(std::memory_order_relaxed)
+                      << "  Flushes: " << c.tlb.flushes.load(std::memory_order_relaxed)
+                      << "  Hit rate: " << c.tlb.HitRate() << "%\n";
+        }
+        std::cout << "\n";
 
         // List running processes
+        processTable::Snapshot snap = snapshotProcesses();
         std::cout << "Running processes and memory usage:\n";
-        for (auto &procConsole : runningProcesses) {
-            double procMemMiB = (procConsole.process.getMemorySize() * memPerFrame) / 1024.0 / 1024.0;
-            std::cout << procConsole.process.pname << "\t" << procMemMiB << "MiB\n";
+        for (auto &row : snap.running) {
+            double procMemMiB = row.memory / 1024.0 / 1024.0;
+            std::cout << row.pname << "\t" << procMemMiB << "MiB\n";
         }
     }
 
+    // process-smi -w: redraws in place every intervalMs until Enter is pressed. Everything on screen comes from atomic counters
+    // (and the process index for names), so watching doesn't hold up the cores, and only the cells that changed are written.
+    void MainConsole::watchProcessSMI(int intervalMs) {
+        std::atomic<bool> watching{true};
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        terminalScreen::EnableAnsi();
+        cout << "\x1b[?25l"; //hide the cursor while drawing
+
+        std::thread drawer([&]{
+            terminalScreen::Screen screen;
+            uint64_t started = latency::NowNs();
+            while (watching) {
+                VMStat stats = collectVMStat(memManager, coreStates, schedulerTicks);
+                pageReplacement::ReplacementPolicy &policy = *memManager.policy;
+                latency::Summary wait = latencies.Summarize(latency::Wait);
+                latency::Summary turnaround = latencies.Summarize(latency::Turnaround);
+                double memUtil = (stats.totalMemory > 0) ? (double)stats.usedMemory / stats.totalMemory * 100.0 : 0;
+
+                screen.Begin();
+                screen.Print("| PROCESS-SMI V01.00 Driver Version: 01.00 |   every %d ms, press Enter to stop   up %.0fs",
+                    intervalMs, (latency::NowNs() - started) / 1e9);
+                screen.Print("-------------------------------------------");
+                screen.Print("CPU-Util: %6.2f%%   Context switches: %-8llu Ready: %-6llu Running: %-4llu Finished: %llu", CpuUtilization(stats),
+                    (unsigned long long)stats.contextSwitches, (unsigned long long)readyCount.load(std::memory_order_relaxed),
+                    (unsigned long long)stats.busyCores, (unsigned long long)finishedCount.load(std::memory_order_relaxed));
+                screen.Print("Memory Usage: %llu / %llu bytes (%.1f%%)   Paged in: %llu  out: %llu", (unsigned long long)stats.usedMemory,
+                    (unsigned long long)stats.totalMemory, memUtil, (unsigned long long)stats.pagedIn, (unsigned long long)stats.pagedOut);
+                screen.Print("Page policy: %s  Hits: %llu  Faults: %llu  Hit rate: %.2f%%", policy.Name().c_str(),
+                    (unsigned long long)policy.hits.load(), (unsigned long long)policy.faults.load(), policy.HitRate());
+                screen.Print("Queue wait p50/p99: %.1f / %.1f ms   Turnaround p50/p99: %.1f / %.1f ms",
+                    wait.p50 / 1e6, wait.p99 / 1e6, turnaround.p50 / 1e6, turnaround.p99 / 1e6);
+                screen.Print("");
+                screen.Print("%-5s %7s  %-12s  %-6s %-20s %s", "Core", "Util", "", "PID", "Name", "Progress");
+                for (auto &c : coreStates) {
+                    double util = c.ticks.Utilization();
+                    char bar[11];
+                    for (int i = 0; i < 10; i++) bar[i] = (i < (int)(util / 10)) ? '#' : '-';
+                    bar[10] = '\0';
+                    int pid = c.pid.load(std::memory_order_relaxed);
+                    if (pid < 0) {
+                        screen.Print("%-5d %6.1f%%  [%s]  %-6s", c.id, util, bar, "idle");
+                        continue;
+                    }
+                    processIndex::Entry entry;
+                    string name = processes.FindByPid(pid, entry) ? entry.pname : "";
+                    int line = c.line.load(std::memory_order_relaxed), lines = c.lines.load(std::memory_order_relaxed);
+                    int percent = (lines > 0) ? (int)((double)line / lines * 100) : 0;
+                    screen.Print("%-5d %6.1f%%  [%s]  %-6d %-20.20s %5d/%-5d %3d%%", c.id, util, bar, pid, name.c_str(), line, lines, percent);
+                }
+                cout << screen.Render() << std::flush;
+
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait_for(lock, milliseconds(intervalMs), [&]{ return !watching; });
+            }
+        });
+
+        string line;
+        std::getline(std::cin, line);
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            watching = false;
+        }
+        wake.notify_all();
+        drawer.join();
+        cout << "\x1b[?25h" << endl; //cursor back
+    }
+
     void Console::handleInput(string s){
         //handle system calls first, then hand over the string to processcalls
-        std::ostringstream output;
+        processPool::OStringStream output; //pooled, so log lines don't go through malloc
 
         s.erase(std::remove(s.begin(), s.end(), '\n'), s.cend());
         s.erase(std::remove(s.begin(), s.end(), '\r'), s.cend());
@@ -828,13 +1185,7 @@ namespace console{
             regex checkValid("(?:PRINT|print)\\s{0,1}\\((.*?)\\)");
             regex checkSolo("(.*)(?:print|PRINT)(.*)");
             if(std::regex_match(s, checkValid)){;
-                char logTimeOut[30];
-                time_t logTime;
-                struct tm logTimeStamp;
-
-                time(&logTime); 
-                localtime_s(&logTimeStamp, &logTime);
-                output << "(" << std::put_time(&logTimeStamp, "%m/%d/%Y %I:%M:%S%p") << ") Core:" << process.core << " " << regex_replace(s, checkValid, "$1") << endl;
+                output << "(" << wallClock::Now(wallClock::Log) << ") Core:" << process.core << " " << regex_replace(s, checkValid, "$1") << endl;
                 process.log.push_back(output.str());
             }
             else if(std::regex_match(s, checkSolo)){
@@ -856,10 +1207,13 @@ namespace console{
                 process.AddToTableUsingIdentifier(arg1, arg2);
             }
             else if(strcmp(command, "read") == 0 || strcmp(command, "READ") == 0){
-                process.ReadFromAddress(arg1, arg2);
+                //The value lives in the frame's bytes, not in the symbol table. Unmapped addresses read as 0.
+                uint16_t value = 0;
+                if(memory != NULL) memory->Read16(process, virtualAddress(arg2), cpu ? &cpu->tlb : NULL, cpu ? cpu->id : 0, value);
+                process.UpdateTableUsingIdentifier(arg1, value);
             }
             else if(strcmp(command, "write") == 0 || strcmp(command, "WRITE") == 0){
-                process.WriteToAddress(arg1, arg2);
+                if(memory != NULL) memory->Write16(process, virtualAddress(arg2), process.RetrieveValueUsingIdentifier(arg1), cpu ? &cpu->tlb : NULL, cpu ? cpu->id : 0);
             }
             else   
                 handleProcessCalls(s); //IS HERE BECAUSE IT CAPTURES SCREEN -S <PROC_NAME> and other 3 token commands
@@ -916,7 +1270,7 @@ namespace console{
             }
 
             else if(tokens.front() == "clear"){
-                system("cls");
+                terminalScreen::Clear();
                 drawHeader();
                 printProcesses();
             }   
@@ -1007,14 +1361,211 @@ namespace console{
                     cmdScreenHelp();
             }
             else if(tokens.front() == "report-util"){
-                printProcessesToFile();
+                tokens.pop_front();
+                processTable::Format format = processTable::Text;
+                string filename;
+                bool valid = true;
+                while(!tokens.empty()){
+                    if(tokens.front() == "--format"){
+                        tokens.pop_front();
+                        string f = tokens.empty() ? "" : tokens.front();
+                        if(f == "csv") format = processTable::CSV;
+                        else if(f == "jsonl") format = processTable::JSONL;
+                        else if(f == "text") format = processTable::Text;
+                        else valid = false;
+                    }
+                    else filename = tokens.front();
+                    if(!tokens.empty()) tokens.pop_front();
+                }
+                if(valid) printProcessesToFile(format, filename);
+                else cout << "usage: report-util [--format csv|jsonl|text] [file]" << endl;
             }
 
+            else if(tokens.front() == "latency"){
+                latencies.Print(cout);
+            }
+            else if(tokens.front() == "metrics-export"){
+                tokens.pop_front();
+                vector<string> args(tokens.begin(), tokens.end());
+                string usage = "usage: metrics-export http <port> | unix <path> | file <path> [interval ms] | stop";
+                if(args.size() == 1 && args[0] == "stop"){
+                    exporter.Stop();
+                    cout << "Metrics export stopped." << endl;
+                }
+                else if(args.size() >= 2 && (args[0] == "http" || args[0] == "unix" || args[0] == "file")){
+                    metricsExport::Mode mode = (args[0] == "http") ? metricsExport::HTTP : (args[0] == "unix") ? metricsExport::Unix : metricsExport::File;
+                    int interval = 1000;
+                    try{
+                        if(args.size() >= 3) interval = std::stoi(args[2]);
+                    }catch(std::exception& e){
+                        cout << usage << endl;
+                        return;
+                    }
+                    if(exporter.Start(mode, args[1], interval, [this]{ return prometheusMetrics(); })){
+                        if(mode == metricsExport::HTTP) cout << "Serving metrics on http://127.0.0.1:" << args[1] << "/metrics" << endl;
+                        else if(mode == metricsExport::Unix) cout << "Serving metrics on UNIX socket " << args[1] << endl;
+                        else cout << "Writing metrics to " << args[1] << " every " << std::max(interval, 10) << " ms" << endl;
+                    }
+                }
+                else cout << usage << endl;
+            }
+            else if(tokens.front() == "workload"){
+                tokens.pop_front();
+                string action = tokens.empty() ? "" : tokens.front();
+                string file = (tokens.size() == 2) ? tokens.back() : "";
+                if(action == "record" && !file.empty()){
+                    if(workloadLog.IsOpen()) cout << "Already recording, use workload stop first." << endl;
+                    else if(workloadLog.Open(file)) cout << "Recording every generated process to " << file << endl;
+                }
+                else if(action == "replay" && !file.empty()){
+                    vector<workload::Spec> specs;
+                    if(!workload::Load(file, specs)){
+                        cout << "Error: " << file << " is not a workload trace." << endl;
+                    }
+                    else{
+                        stopProcessGenerator();
+                        replaySpecs = specs;
+                        replaying = true;
+                        startProcessGenerator();
+                        cout << "Replaying " << specs.size() << " processes from " << file << endl;
+                    }
+                }
+                else if(action == "stop" && tokens.size() == 1){
+                    if(workloadLog.IsOpen()){
+                        workloadLog.Close();
+                        cout << workloadLog.Recorded() << " processes recorded." << endl;
+                    }
+                    if(replaying){
+                        stopProcessGenerator();
+                        cout << "Replay stopped." << endl;
+                    }
+                }
+                else cout << "usage: workload record <file> | replay <file> | stop" << endl;
+            }
+            else if(tokens.front() == "config"){
+                tokens.pop_front();
+                string action = tokens.empty() ? "" : tokens.front();
+                if(action == "set" && tokens.size() == 3){
+                    tokens.pop_front();
+                    string key = tokens.front();
+                    string value = tokens.back();
+                    Config next = config;
+                    applyTunables(next, tunables());
+                    if(const char* error = setConfigValue(next, key.c_str(), value.c_str())) cout << "Error: " << key << " " << value << ": " << error << "." << endl;
+                    else if(!isLiveSetting(key.c_str())) cout << key << " can't change while running, edit " << configPath << " and restart." << endl;
+                    else if(const char* error = invalidTunables(TunablesOf(next))) cout << "Error: " << error << "." << endl;
+                    else{
+                        publishTunables(TunablesOf(next));
+                        config = next;
+                        cout << key << " set to " << value << ", cores pick it up at their next quantum." << endl;
+                    }
+                }
+                else if(action == "reload" && tokens.size() == 1){
+                    Config file;
+                    if(loadConfig(configPath.c_str(), file)){
+                        Tunables t = TunablesOf(file);
+                        if(const char* error = invalidTunables(t)) cout << "Error: " << error << ", " << configPath << " not applied." << endl;
+                        else{
+                            publishTunables(t);
+                            if(!sameRestartSettings(config, file)) cout << "Settings other than the live ones changed in " << configPath << ", they take effect on restart." << endl;
+                            applyTunables(config, t);
+                            cout << "Reloaded " << configPath << ", cores pick it up at their next quantum." << endl;
+                        }
+                    }
+                }
+                else if(action.empty()){
+                    const Tunables& t = tunables();
+                    cout << "Config version " << t.version << endl;
+                    cout << left << setw(22) << "quantum-cycles" << t.quantumCycles << endl;
+                    cout << setw(22) << "delays-per-exec" << t.delayPerExec << endl;
+                    cout << setw(22) << "batch-process-freq" << t.batchProcessFreq << endl;
+                    cout << setw(22) << "min-ins" << t.minIns << endl;
+                    cout << setw(22) << "max-ins" << t.maxIns << endl;
+                    cout << setw(22) << "min-mem-per-proc" << t.minMemPerProc << endl;
+                    cout << setw(22) << "max-mem-per-proc" << t.maxMemPerProc << endl;
+                }
+                else cout << "usage: config [set <key> <value> | reload]" << endl;
+            }
+            else if(tokens.front() == "lockstat"){
+                tokens.pop_front();
+                if(!tokens.empty() && tokens.front() == "reset"){
+                    queueMutex.Reset();
+                    processStatusMutex.Reset();
+                    cout << "Lock statistics reset." << endl;
+                }
+                else{
+                    lockStat::ProfiledMutex::PrintHeader(cout);
+                    queueMutex.Print(cout);
+                    processStatusMutex.Print(cout);
+                }
+            }
+            else if(tokens.front() == "trace"){
+                tokens.pop_front();
+                string action = tokens.empty() ? "" : tokens.front();
+                if(action == "start"){
+                    tracer.Start();
+                    cout << "Tracing scheduler events." << endl;
+                }
+                else if(action == "stop"){
+                    tracer.Stop();
+                    cout << "Tracing stopped." << endl;
+                }
+                else if(action == "dump" && tokens.size() == 2){
+                    string file = tokens.back();
+                    auto nameOf = [this](int pid){
+                        processIndex::Entry e;
+                        return processes.FindByPid(pid, e) ? e.pname : "pid " + std::to_string(pid);
+                    };
+                    if(tracer.Dump(file, nameOf, numCPU))
+                        cout << "Trace written to " << file << " (open in chrome://tracing or ui.perfetto.dev)" << endl;
+                    else
+                        cout << "Error: Could not open " << file << " for writing." << endl;
+                }
+                else cout << "usage: trace start|stop|dump <file>" << endl;
+            }
+            else if(tokens.front() == "snapshot-read"){
+                tokens.pop_front();
+                char* end = NULL;
+                unsigned long quantum = tokens.empty() ? 0 : strtoul(tokens.front().c_str(), &end, 10);
+                if(tokens.empty() || end == tokens.front().c_str() || *end != '\0' || tokens.front()[0] == '-' || quantum > UINT32_MAX){
+                    cout << "usage: snapshot-read <quantum> [file]" << endl;
+                }
+                else{
+                    vector<Frame> snapshotFrames;
+                    time_t when;
+                    tokens.pop_front();
+                    if(!snapshotStream::ReadSnapshot(filePrefix + "memory_stamps", quantum, snapshotFrames, memManager.memoryPerFrame, when)){
+                        cout << "No snapshot for quantum " << quantum << endl;
+                    }
+                    else{
+                        string stamp = wallClock::Format(when, wallClock::Log);
+                        if(tokens.empty()){
+                            memoryAllocator::printMemorySnapshot(cout, snapshotFrames, stamp);
+                        }
+                        else{
+                            std::ofstream out(tokens.front());
+                            memoryAllocator::printMemorySnapshot(out, snapshotFrames, stamp);
+                            cout << "Snapshot written to " << tokens.front() << endl;
+                        }
+                    }
+                }
+            }
             else if(tokens.front() == "vmstat") {
-                printVMStat(memManager);
+                printVMStat(memManager, coreStates, schedulerTicks);
             }
             else if(tokens.front() == "process-smi"){ 
-                printProcessSMI();
+                tokens.pop_front();
+                if(tokens.size() == 2 && tokens.front() == "-w"){
+                    try{
+                        watchProcessSMI(std::max(std::stoi(tokens.back()), 50));
+                    }catch(std::exception& e){
+                        cout << "usage: process-smi [-w <ms>]" << endl;
+                    }
+                }
+                else if(tokens.empty())
+                    printProcessSMI();
+                else
+                    cout << "usage: process-smi [-w <ms>]" << endl;
             }
             else{
                 cout << "\"" << tokens.front() << invalid << endl;
@@ -1023,19 +1574,4 @@ namespace console{
     }
 }
 
-
-typedef struct {
-    int num_cpu;
-    char scheduler[10];
-    int quantum_cycles;
-    int batch_process_freq;
-    int min_ins;
-    int max_ins;
-    int delay_per_exec;
-    int max_overall_mem;
-    int mem_per_frame;
-    int min_mem_per_proc;
-    int max_mem_per_proc;
-} Config;
-
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,10 @@
 
 #include <thread>
 #include <iostream>
+#include <atomic>
+#include <cstdint>
+
+#include "tlb.h"
 
 
 namespace console {
@@ -16,7 +20,53 @@ using std::thread;
 
 namespace cpucore {
 
+    // Where a core's ticks went. Only the owning core writes these; vmstat, process-smi and report-util add them up on demand.
+    // Own cache line so one core bumping its counters every tick doesn't invalidate its neighbour's.
+    struct alignas(64) Ticks {
+        std::atomic<uint64_t> busy{0};          // executing an instruction
+        std::atomic<uint64_t> idle{0};          // nothing to run, or the next process doesn't fit in memory yet
+        std::atomic<uint64_t> contextSwitch{0}; // switching to a different process
+        std::atomic<uint64_t> sleepWait{0};     // holding a process that's executing SLEEP
+
+        uint64_t Total() const {
+            return busy.load(std::memory_order_relaxed) + idle.load(std::memory_order_relaxed)
+                 + contextSwitch.load(std::memory_order_relaxed) + sleepWait.load(std::memory_order_relaxed);
+        }
+
+        // Busy share of every tick so far, in percent.
+        double Utilization() const {
+            uint64_t total = Total();
+            return (total > 0) ? (double)busy.load(std::memory_order_relaxed) / total * 100.0 : 0;
+        }
+    };
+
+    // Per-core state that outlives the process currently running on it.
+    struct alignas(64) Core {
+        int id = 0;
+        tlb::TLB tlb;
+        int lastAsid = -1;      // pid of the process that ran last on this core
+        bool asidTagged = false; // true: keep TLB entries across switches (tagged by pid), false: flush on every switch
+
+        // Counters bumped by the core itself, so reports can read them without scanning anything.
+        Ticks ticks;
+        std::atomic<uint64_t> contextSwitches{0};  // times the core switched to a different process
+        std::atomic<bool> busy{false};             // running a process right now
+        std::atomic<int> pid{-1};                  // what it's running and how far along, for process-smi -w
+        std::atomic<int> line{0};
+        std::atomic<int> lines{0};
+
+        // Called when the core picks up a process. Flushes the TLB unless entries are ASID tagged.
+        void ContextSwitch(int asid) {
+            if (asid != lastAsid) {
+                contextSwitches.fetch_add(1, std::memory_order_relaxed);
+                ticks.contextSwitch.fetch_add(1, std::memory_order_relaxed); // a switch costs the core a tick
+                if (!asidTagged) tlb.Flush();
+            }
+            lastAsid = asid;
+        }
+    };
+
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,8 @@
 
 #include <string>
 #include <string.h>
+#include <vector>
+#include <atomic>
 
 using std::string;
 
@@ -14,10 +16,137 @@ struct Frame {
 	int startAddress_i;  //decimal representation
 	int endAddress_i;  //decimal representation
 	string pid = "";
+	int page = -1;       //virtual page of the owner that this frame holds, -1 when free
 
 	bool operator==(const struct Frame& f) const{
 		return f.id == this->id;
 	}
 };
 
+//A run of `count` consecutive virtual pages sitting in consecutive frames starting at firstFrame. firstFrame is -1 when the pages aren't resident.
+struct Extent {
+	int firstFrame;
+	int count;
+};
+
+//Small vector of extents. Up to 4 live inline, which covers almost every process; more than that spills to the heap.
+class ExtentList {
+	public:
+		int size() const { return n; }
+		Extent& operator[](int i) { return data()[i]; }
+		const Extent& operator[](int i) const { return spilled ? heap[i] : local[i]; }
+
+		void push_back(Extent e) {
+			insert(n, e);
+		}
+
+		void insert(int pos, Extent e) {
+			if (!spilled && n == inlineCapacity) {
+				heap.assign(local, local + n);
+				spilled = true;
+			}
+			if (spilled) {
+				heap.insert(heap.begin() + pos, e);
+			} else {
+				for (int i = n; i > pos; --i) local[i] = local[i - 1];
+				local[pos] = e;
+			}
+			n++;
+		}
+
+		void erase(int pos) {
+			if (spilled) heap.erase(heap.begin() + pos);
+			else for (int i = pos; i < n - 1; ++i) local[i] = local[i + 1];
+			n--;
+		}
+
+		void clear() {
+			n = 0;
+			spilled = false;
+			heap.clear();
+		}
+
+	private:
+		static const int inlineCapacity = 4;
+		Extent local[inlineCapacity];
+		std::vector<Extent> heap;
+		int n = 0;
+		bool spilled = false;
+
+		Extent* data() { return spilled ? heap.data() : local; }
+};
+
+//Where each virtual page of a process lives, as extents covering pages 0..numPages-1 in order.
+//Shared between all copies of the process so evictions and compaction are seen everywhere.
+struct PageTable {
+	int pid = -1;
+	string pname;
+	int numPages = 0;
+	ExtentList extents;
+	std::atomic<int> resident{0}; //pages currently in a frame, readable without the allocator's locks
+	bool released = false;     //process was deallocated, copies still holding this table must not fault pages back in
+
+	//Start with every page non-resident.
+	void Reset(int pages) {
+		numPages = pages;
+		extents.clear();
+		if (pages > 0) extents.push_back({-1, pages});
+		resident = 0;
+	}
+
+	//Frame holding `page`, -1 if it isn't resident.
+	int FrameOf(int page) const {
+		for (int i = 0, start = 0; i < extents.size(); start += extents[i].count, ++i) {
+			if (page < start + extents[i].count)
+				return extents[i].firstFrame == -1 ? -1 : extents[i].firstFrame + (page - start);
+		}
+		return -1;
+	}
+
+	//Point one page at `frame` (-1 to drop it). Splits the extent it sits in and merges neighbours that line up again.
+	void SetPage(int page, int frame) {
+		int i = 0, start = 0;
+		while (i < extents.size() && page >= start + extents[i].count) start += extents[i++].count;
+		if (i == extents.size()) return;
+
+		Extent e = extents[i];
+		int before = page - start, after = e.count - before - 1;
+		int oldFrame = (e.firstFrame == -1) ? -1 : e.firstFrame + before;
+		if (oldFrame == frame) return;
+		if (oldFrame == -1) resident++;
+		if (frame == -1) resident--;
+
+		extents.erase(i);
+		int at = i;
+		if (before > 0) extents.insert(at++, {e.firstFrame, before});
+		extents.insert(at, {frame, 1});
+		if (after > 0) extents.insert(at + 1, {e.firstFrame == -1 ? -1 : e.firstFrame + before + 1, after});
+
+		//Merge around the new single-page extent.
+		if (at + 1 < extents.size() && joins(extents[at], extents[at + 1])) {
+			extents[at].count += extents[at + 1].count;
+			extents.erase(at + 1);
+		}
+		if (at > 0 && joins(extents[at - 1], extents[at])) {
+			extents[at - 1].count += extents[at].count;
+			extents.erase(at);
+		}
+	}
+
+	//Calls fn(page, frame) for each resident page.
+	template <typename F>
+	void ForEachResident(F fn) const {
+		for (int i = 0, start = 0; i < extents.size(); start += extents[i].count, ++i) {
+			if (extents[i].firstFrame == -1) continue;
+			for (int k = 0; k < extents[i].count; ++k) fn(start + k, extents[i].firstFrame + k);
+		}
+	}
+
+	private:
+		static bool joins(const Extent& a, const Extent& b) {
+			if (a.firstFrame == -1 || b.firstFrame == -1) return a.firstFrame == b.firstFrame;
+			return b.firstFrame == a.firstFrame + a.count;
+		}
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+#ifndef latencyH
+#define latencyH
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+
+using std::vector;
+
+namespace latency {
+
+	//Monotonic nanoseconds, what every state transition is stamped with. Only differences mean anything.
+	inline uint64_t NowNs(){
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//HDR-style log-linear histogram: exact below 64 ns, then 32 buckets per power of two (about 3% error) up to 2^64 ns.
+	//Record is one relaxed fetch_add on a counter nobody else writes (one histogram per core), so it never waits.
+	class Histogram {
+		public:
+			static const int subBits = 6;
+			static const uint64_t subCount = 1ull << subBits;	//64
+			static const int numBuckets = subCount + (64 - subBits) * (subCount / 2);
+
+			Histogram() : counts(new std::atomic<uint64_t>[numBuckets]) {
+				for(int i = 0; i < numBuckets; i++) counts[i].store(0, std::memory_order_relaxed);
+			}
+
+			void Record(uint64_t ns){
+				counts[IndexOf(ns)].fetch_add(1, std::memory_order_relaxed);
+				total.fetch_add(1, std::memory_order_relaxed);
+				sum.fetch_add(ns, std::memory_order_relaxed);
+				uint64_t m = max.load(std::memory_order_relaxed);
+				while(ns > m && !max.compare_exchange_weak(m, ns, std::memory_order_relaxed)){}
+			}
+
+			//Adds this histogram's counts into a plain array, for reading percentiles off several cores at once.
+			void AddTo(vector<uint64_t>& into, uint64_t& count, uint64_t& maxNs){
+				into.resize(numBuckets, 0);
+				for(int i = 0; i < numBuckets; i++) into[i] += counts[i].load(std::memory_order_relaxed);
+				count += total.load(std::memory_order_relaxed);
+				uint64_t m = max.load(std::memory_order_relaxed);
+				if(m > maxNs) maxNs = m;
+			}
+
+			uint64_t Sum(){ return sum.load(std::memory_order_relaxed); }
+
+			static int IndexOf(uint64_t v){
+				if(v < subCount) return (int)v;
+				int e = log2Floor(v);							//v >= 64, so e >= subBits
+				int shift = e - (subBits - 1);
+				uint64_t m = v >> shift;						//top subBits bits, in [32, 64)
+				return (int)(subCount + (shift - 1) * (subCount / 2) + (m - subCount / 2));
+			}
+
+			//Middle of the bucket's range, what a percentile that lands in it reports.
+			static uint64_t ValueOf(int index){
+				if(index < (int)subCount) return index;
+				int shift = (index - subCount) / (subCount / 2) + 1;
+				uint64_t m = (index - subCount) % (subCount / 2) + subCount / 2;
+				return (m << shift) + ((1ull << shift) >> 1);
+			}
+
+		private:
+			std::unique_ptr<std::atomic<uint64_t>[]> counts;
+			std::atomic<uint64_t> total{0};
+			std::atomic<uint64_t> sum{0};
+			std::atomic<uint64_t> max{0};
+
+			static int log2Floor(uint64_t x){
+				int e = 0;
+				if(x >> 32){ e += 32; x >>= 32; }
+				if(x >> 16){ e += 16; x >>= 16; }
+				if(x >> 8){ e += 8; x >>= 8; }
+				if(x >> 4){ e += 4; x >>= 4; }
+				if(x >> 2){ e += 2; x >>= 2; }
+				if(x >> 1){ e += 1; }
+				return e;
+			}
+	};
+
+	//Value at fraction p of a merged set of Histogram counts.
+	inline uint64_t Percentile(const vector<uint64_t>& counts, uint64_t total, double p){
+		uint64_t rank = (uint64_t)(p * total + 0.999999);
+		if(rank == 0) rank = 1;
+		uint64_t seen = 0;
+		for(size_t i = 0; i < counts.size(); i++){
+			seen += counts[i];
+			if(seen >= rank) return Histogram::ValueOf(i);
+		}
+		return 0;
+	}
+
+	//What gets measured, all from arrival (the process being generated).
+	enum Metric { Wait = 0, Response, Turnaround, Admission, NumMetrics };
+
+	inline const char* MetricName(Metric m){
+		switch(m){
+			case Wait: return "queue wait";
+			case Response: return "first response";
+			case Turnaround: return "turnaround";
+			default: return "admission";
+		}
+	}
+
+	struct Summary {
+		uint64_t count = 0;
+		uint64_t sum = 0;			//ns, for averages and the Prometheus summary
+		uint64_t p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0;	//ns
+	};
+
+	//One set of histograms per core (plus one for the round robin scheduler thread), merged only when someone asks.
+	class Recorder {
+		public:
+			void SetSlots(int n){
+				slots.clear();
+				for(int i = 0; i < n; i++) slots.emplace_back(new Slot());
+			}
+
+			void Record(int slot, Metric metric, uint64_t ns){
+				if(slot < 0 || slot >= (int)slots.size()) return;
+				slots[slot]->h[metric].Record(ns);
+			}
+
+			Summary Summarize(Metric metric){
+				Summary s;
+				vector<uint64_t> merged;
+				for(auto& slot : slots){
+					slot->h[metric].AddTo(merged, s.count, s.max);
+					s.sum += slot->h[metric].Sum();
+				}
+				if(s.count == 0) return s;
+				s.p50 = Percentile(merged, s.count, 0.50);
+				s.p90 = Percentile(merged, s.count, 0.90);
+				s.p99 = Percentile(merged, s.count, 0.99);
+				s.p999 = Percentile(merged, s.count, 0.999);
+				//Bucket midpoints can overshoot the largest value actually seen.
+				s.p50 = std::min(s.p50, s.max);
+				s.p90 = std::min(s.p90, s.max);
+				s.p99 = std::min(s.p99, s.max);
+				s.p999 = std::min(s.p999, s.max);
+				return s;
+			}
+
+			//Table used by the latency command and report-util.
+			void Print(std::ostream& out){
+				char line[160];
+				snprintf(line, sizeof(line), "%-16s %10s %12s %12s %12s %12s %12s\n", "Latency (ms)", "count", "p50", "p90", "p99", "p999", "max");
+				out << line;
+				for(int m = 0; m < NumMetrics; m++){
+					Summary s = Summarize((Metric)m);
+					snprintf(line, sizeof(line), "%-16s %10llu %12.3f %12.3f %12.3f %12.3f %12.3f\n", MetricName((Metric)m), (unsigned long long)s.count,
+						s.p50 / 1e6, s.p90 / 1e6, s.p99 / 1e6, s.p999 / 1e6, s.max / 1e6);
+					out << line;
+				}
+			}
+
+		private:
+			struct Slot {
+				Histogram h[NumMetrics];
+			};
+			vector<std::unique_ptr<Slot>> slots;
+	};
+}
+
+#endif
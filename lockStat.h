@@ -0,0 +1,178 @@
+#pragma once
+#ifndef lockStatH
+#define lockStatH
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "latency.h"
+
+using std::vector;
+using std::string;
+
+namespace lockStat {
+
+	//Counters for one place in the code that takes a lock. Only written while that lock is held, so no atomics needed.
+	struct SiteStats {
+		const char* name = NULL;
+		uint64_t acquisitions = 0;
+		uint64_t contended = 0;		//acquisitions that had to wait for another thread
+		uint64_t waitNs = 0;		//total time spent waiting, contended acquisitions only
+		uint64_t holdNs = 0;
+		std::unique_ptr<latency::Histogram> hold;
+	};
+
+	//std::mutex that keeps acquisition, contention, wait and hold time per call site. Meets Lockable, so std::lock_guard and
+	//std::condition_variable_any work with it (those count as site "other"); lockStat::Lock says which site it is.
+	//The fast path is a try_lock and two clock reads; the clock is only read a third time when the lock was contended.
+	class ProfiledMutex {
+		public:
+			static const int maxSites = 24;
+
+			explicit ProfiledMutex(const char* lockName) : name(lockName) {}
+
+			void lock(){ lock("other"); }
+			void lock(const char* site){
+				uint64_t waited = 0;
+				bool contended = false;
+				if(!m.try_lock()){
+					uint64_t before = latency::NowNs();
+					m.lock();
+					waited = latency::NowNs() - before;
+					contended = true;
+				}
+				holder = find(site);
+				holder->acquisitions++;
+				if(contended){
+					holder->contended++;
+					holder->waitNs += waited;
+				}
+				heldSince = latency::NowNs();
+			}
+
+			bool try_lock(){ return try_lock("other"); }
+			bool try_lock(const char* site){
+				if(!m.try_lock()) return false;
+				holder = find(site);
+				holder->acquisitions++;
+				heldSince = latency::NowNs();
+				return true;
+			}
+
+			void unlock(){
+				uint64_t held = latency::NowNs() - heldSince;
+				holder->holdNs += held;
+				holder->hold->Record(held);
+				m.unlock();
+			}
+
+			const char* Name(){ return name; }
+
+			//One line per call site then the lock's total. Takes the lock for as long as it takes to copy the counters.
+			void Print(std::ostream& out){
+				vector<SiteStats> copy;
+				vector<vector<uint64_t>> holds;
+				{
+					std::lock_guard<std::mutex> lock(m);
+					for(int i = 0; i < numSites; i++){
+						SiteStats s;
+						s.name = sites[i].name;
+						s.acquisitions = sites[i].acquisitions;
+						s.contended = sites[i].contended;
+						s.waitNs = sites[i].waitNs;
+						s.holdNs = sites[i].holdNs;
+						copy.push_back(std::move(s));
+						holds.emplace_back();
+						uint64_t count = 0, maxNs = 0;
+						sites[i].hold->AddTo(holds.back(), count, maxNs);
+					}
+				}
+
+				SiteStats total;
+				total.name = "total";
+				vector<uint64_t> totalHold;
+				for(size_t i = 0; i < copy.size(); i++){
+					total.acquisitions += copy[i].acquisitions;
+					total.contended += copy[i].contended;
+					total.waitNs += copy[i].waitNs;
+					total.holdNs += copy[i].holdNs;
+					totalHold.resize(holds[i].size(), 0);
+					for(size_t b = 0; b < holds[i].size(); b++) totalHold[b] += holds[i][b];
+				}
+				for(size_t i = 0; i < copy.size(); i++) printRow(out, copy[i], holds[i]);
+				printRow(out, total, totalHold);
+			}
+
+			void Reset(){
+				std::lock_guard<std::mutex> lock(m);
+				for(int i = 0; i < numSites; i++){
+					sites[i].acquisitions = sites[i].contended = sites[i].waitNs = sites[i].holdNs = 0;
+					sites[i].hold.reset(new latency::Histogram());
+				}
+			}
+
+			static void PrintHeader(std::ostream& out){
+				char line[200];
+				snprintf(line, sizeof(line), "%-20s %-28s %10s %10s %6s %12s %10s %10s %10s\n", "Lock", "Site", "acquired", "contended", "cont%",
+					"wait ms", "hold p50us", "hold p99us", "hold ms");
+				out << line;
+			}
+
+		private:
+			std::mutex m;
+			const char* name;
+			SiteStats sites[maxSites];
+			int numSites = 0;
+			SiteStats* holder = NULL;	//site of the current owner
+			uint64_t heldSince = 0;
+
+			//Sites are string literals, so a pointer compare finds them on the second visit. Called with m held.
+			SiteStats* find(const char* site){
+				for(int i = 0; i < numSites; i++)
+					if(sites[i].name == site) return &sites[i];
+				for(int i = 0; i < numSites; i++)
+					if(strcmp(sites[i].name, site) == 0) return &sites[i];
+				if(numSites == maxSites) return &sites[maxSites - 1]; //out of room, lumped with the last one
+				sites[numSites].name = site;
+				sites[numSites].hold.reset(new latency::Histogram());
+				return &sites[numSites++];
+			}
+
+			void printRow(std::ostream& out, const SiteStats& s, const vector<uint64_t>& hold){
+				char line[200];
+				uint64_t count = s.acquisitions;
+				double p50 = count ? latency::Percentile(hold, count, 0.50) / 1e3 : 0;
+				double p99 = count ? latency::Percentile(hold, count, 0.99) / 1e3 : 0;
+				snprintf(line, sizeof(line), "%-20s %-28s %10llu %10llu %5.1f%% %12.3f %10.2f %10.2f %10.3f\n", name, s.name,
+					(unsigned long long)s.acquisitions, (unsigned long long)s.contended, count ? 100.0 * s.contended / count : 0.0,
+					s.waitNs / 1e6, p50, p99, s.holdNs / 1e6);
+				out << line;
+			}
+	};
+
+	//lock_guard that also names the call site, e.g. Lock lock(queueMutex, "cpuWorker: dequeue").
+	//Also BasicLockable itself, so condition_variable_any can wait on it and the reacquire is counted against the same site.
+	class Lock {
+		public:
+			Lock(ProfiledMutex& mutex, const char* siteName) : m(mutex), site(siteName) { lock(); }
+			~Lock(){ if(owns) m.unlock(); }
+			Lock(const Lock&) = delete;
+			Lock& operator=(const Lock&) = delete;
+
+			void lock(){ m.lock(site); owns = true; }
+			void unlock(){ owns = false; m.unlock(); }
+
+		private:
+			ProfiledMutex& m;
+			const char* site;
+			bool owns = false;
+	};
+}
+
+#endif
@@ -14,6 +14,9 @@
 #include <algorithm>
 #include <list>
 #include <fstream> //for file operations
+#include <cerrno>
+#include <cctype>
+#include <memory>
 
 #include "console.h" //For the console class
 #include "process.h"
@@ -31,93 +34,357 @@ using std::thread;
 using std::ref;
 
 
-Config configSetup() {
-    Config config;
-    FILE* file = fopen("config.txt", "r");
-
-    if (!file) {
-        perror("Error opening config.txt");
-        exit(EXIT_FAILURE);
-    }
+// Builds a MainConsole (which starts its cores) from config. filePrefix goes in front of the files it writes by itself,
+// the archive, the memory snapshots and report-util without a file name, so sweep runs don't write over each other's.
+static MainConsole* newMainConsole(const Config& config, const string& filePrefix = "") {
+    MainConsole* mainConsole = new MainConsole(config.num_cpu, config.scheduler, config.quantum_cycles,
+                            config.batch_process_freq, config.min_ins,
+                            config.max_ins, config.delay_per_exec,
+                            config.max_overall_mem, config.mem_per_frame, config.min_mem_per_proc, config.max_mem_per_proc,
+                            config.replacement_policy); //fifo, clock, lru, arc or none
+    mainConsole->config = config; //config set starts from this
+    mainConsole->tlbAsidTagged = strcmp(config.tlb_mode, "asid") == 0; //flush (default) or asid
+    mainConsole->memManager.contiguous = strcmp(config.allocator, "contiguous") == 0; //paging (default) or contiguous
+    if (config.compaction) mainConsole->memManager.StartCompactor(config.compaction_threshold); //on allocation failure or past the fragmentation threshold
+    mainConsole->finishedRetention = std::max(config.finished_retention, 0); //older finished processes go to csopesy-archive.txt
+    mainConsole->filePrefix = filePrefix;
+    mainConsole->archivePath = filePrefix + mainConsole->archivePath;
+    if (mainConsole->finishedRetention > 0 && !mainConsole->archive.Open(mainConsole->archivePath))
+        std::cerr << "Finished processes will be kept in memory instead." << std::endl;
+    if (config.memory_snapshots) mainConsole->snapshots.Open(filePrefix + "memory_stamps"); //memory_stamps.bin/.idx/.names, read back with snapshot-read
+    return mainConsole;
+}
 
-    char line[128];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove trailing newline
-        line[strcspn(line, "\r\n")] = 0;
-
-        char key[64] = {0};
-        char value[64] = {0};
-
-        if (sscanf(line, "%s %63[^\n]", key, value) == 2) {
-            // Strip trailing newlines/spaces from value
-            value[strcspn(value, "\r\n")] = 0;
-
-            // Debug print
-            std::cout << "Key: [" << key << "], Value: [" << value << "]" << std::endl;
-
-            if (strcmp(key, "num-cpu") == 0) {
-                config.num_cpu = atoi(value);
-            } else if (strcmp(key, "scheduler") == 0) {
-                // Strip surrounding quotes if they exist
-                size_t len = strlen(value);
-                if (value[0] == '"' && value[len - 1] == '"') {
-                    value[len - 1] = '\0'; // remove trailing quote
-                    strncpy(config.scheduler, value + 1, sizeof(config.scheduler) - 1);
-                } else {
-                    strncpy(config.scheduler, value, sizeof(config.scheduler) - 1);
-                }
-                config.scheduler[sizeof(config.scheduler) - 1] = '\0';
-            } else if (strcmp(key, "quantum-cycles") == 0) {
-                config.quantum_cycles = atoi(value);
-            } else if (strcmp(key, "batch-process-freq") == 0) {
-                config.batch_process_freq = atoi(value);
-            } else if (strcmp(key, "min-ins") == 0) {
-                config.min_ins = atoi(value);
-            } else if (strcmp(key, "max-ins") == 0) {
-                config.max_ins = atoi(value);
-            } else if (strcmp(key, "delays-per-exec") == 0) {
-                config.delay_per_exec = atoi(value);
-            } else if (strcmp(key, "max-overall-mem") == 0) {
-                config.max_overall_mem = atoi(value);
-            } else if (strcmp(key, "mem-per-frame") == 0) {
-                config.mem_per_frame = atoi(value);
-            } else if (strcmp(key, "min-mem-per-proc") == 0) {
-                config.min_mem_per_proc = atoi(value);
-            } else if (strcmp(key, "max-mem-per-proc") == 0) {
-                config.max_mem_per_proc = atoi(value);
-            } else {
-                std::cerr << "Unknown config key: " << key << std::endl;
-            }
-        } else {
-            std::cerr << "Malformed line in config.txt: " << line << std::endl;
-        }
+// The scheduler thread for config.scheduler. Not joinable if the scheduler is unknown.
+static std::thread startScheduler(MainConsole& mainConsole, const Config& config) {
+    if (strcmp(config.scheduler,"fcfs" )== 0) {
+        cout << "Using FCFS scheduler." << endl;
+        return thread(&MainConsole::FCFSscheduler, &mainConsole, 0);
+    } else if (strcmp(config.scheduler,"rr" )== 0) {
+        cout << "Using Round Robin scheduler." << endl;
+        return thread(&MainConsole::rrscheduler, &mainConsole, 0);
     }
-
-    fclose(file);
-    return config;
+    std :: cerr << "Unknown scheduler in config: " << config.scheduler << endl;
+    return thread();
 }
 
 
- void startScreen (){
+ bool startScreen (){
 	cout << "Hello User! Type \"initialize\" to start.\n" << endl;
 	string input = "";
 	while(strcmp(input.c_str(), "initialize") != 0){
 		cout << ">root/>"; //prompt
-		std::getline(cin, input);
+		if(!std::getline(cin, input)) return false; //input closed before initialize
 	}
+	return true;
  }
 
-int main(){
-	startScreen(); //Start the screen to prompt the user to initialize the program
+// Time since the batch started, in ms.
+static long batchElapsedMs(uint64_t startNs){
+	return (long)((latency::NowNs() - startNs) / 1000000);
+}
+
+// How long the end of a batch waits for the remaining processes before giving up on them.
+static const long finalWaitMs = 10 * 60 * 1000;
+
+// Blocks until every process created so far has finished, or timeoutMs passes (0: no limit). False on timeout.
+static bool waitForFinished(MainConsole& mainConsole, long timeoutMs){
+	uint64_t startNs = latency::NowNs();
+	while(mainConsole.replaying.load()){ //a replay isn't done until its last process has arrived
+		if(timeoutMs > 0 && batchElapsedMs(startNs) >= timeoutMs) return false;
+		std::this_thread::sleep_for(milliseconds(5));
+	}
+	uint64_t target = mainConsole.processes.Size();
+	while(mainConsole.finishedCount.load() < target){
+		if(timeoutMs > 0 && batchElapsedMs(startNs) >= timeoutMs) return false;
+		std::this_thread::sleep_for(milliseconds(5));
+	}
+	return true;
+}
+
+// --batch <script>: one command per line, optionally prefixed with the ms (since the batch started) to run it at.
+// "wait [timeout ms]" blocks until every process created so far (and the whole of a workload replay) has finished,
+// "#" starts a comment.
+//   0     scheduler-start
+//   2000  scheduler-stop
+//   wait
+//   report-util --format csv run.csv
+// At the end the generator is stopped, the remaining processes run to completion and a summary is printed.
+static bool runBatch(MainConsole& mainConsole, const char* scriptPath, uint64_t startNs){
+	std::ifstream script(scriptPath);
+	if(!script){
+		std::cerr << "Error opening batch script " << scriptPath << std::endl;
+		return false;
+	}
+	string line;
+	int lineNumber = 0;
+	while(std::getline(script, line)){
+		lineNumber++;
+		line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+		size_t first = line.find_first_not_of(" \t\r");
+		if(first == string::npos) continue;
+		line = line.substr(first);
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+
+		if(isdigit((unsigned char)line[0])){
+			long at = atol(line.c_str());
+			size_t command = line.find_first_not_of("0123456789");
+			line = (command == string::npos) ? "" : line.substr(line.find_first_not_of(" \t", command));
+			long now = batchElapsedMs(startNs);
+			if(at > now) std::this_thread::sleep_for(milliseconds(at - now));
+			if(line.empty()) continue;
+		}
+
+		cout << "[" << batchElapsedMs(startNs) << " ms] >root/>" << line << endl;
+		if(line == "wait" || line.compare(0, 5, "wait ") == 0){
+			long timeoutMs = (line.size() > 5) ? atol(line.c_str() + 5) : 0;
+			if(!waitForFinished(mainConsole, timeoutMs))
+				cout << "wait timed out on line " << lineNumber << " (" << mainConsole.finishedCount.load() << "/" << mainConsole.processes.Size() << " finished)" << endl;
+		}
+		else if(line == "exit") break;
+		else mainConsole.handleInput(line);
+	}
+
+	// Let whatever was generated run to completion (a replay runs to its last process first), for up to finalWaitMs
+	uint64_t waitStartNs = latency::NowNs();
+	while(mainConsole.replaying.load() && batchElapsedMs(waitStartNs) < finalWaitMs) std::this_thread::sleep_for(milliseconds(5));
+	mainConsole.generatingProcesses = false;
+	if(mainConsole.processGeneratorThread.joinable()) mainConsole.processGeneratorThread.join();
+	long remainingMs = std::max(finalWaitMs - (long)batchElapsedMs(waitStartNs), 1L);
+	if(!waitForFinished(mainConsole, remainingMs)){
+		processTable::Snapshot snap = mainConsole.snapshotProcesses();
+		auto unfinished = [](const char* state, const processTable::Row& r){
+			cout << "  " << state << " " << r.pname << " (pid " << r.pid << ") " << r.currLine << "/" << r.lineCount << endl;
+		};
+		cout << "Gave up waiting after " << finalWaitMs / 1000 << " s, " << snap.ready.Size() + snap.running.size() << " processes unfinished:" << endl;
+		for(const processTable::Row& r : snap.running) unfinished("running", r);
+		snap.ready.ForEach([&](const processTable::Row& r){ unfinished("ready  ", r); });
+	}
+	return true;
+}
+
+// What a batch run came to, for the batch summary and the --sweep table.
+struct BatchResult {
+	uint64_t finished = 0;
+	double makespan = 0;			//s, batch start to the last process finishing
+	uint64_t makespanTicks = 0;		//the same in virtual time (MainConsole::virtualTick), ticks per core
+	double throughput = 0;			//processes/s
+	double utilization = 0;			//%
+	uint64_t contextSwitches = 0;
+	latency::Summary wait;
+	latency::Summary turnaround;
+};
+
+static BatchResult collectBatchResult(MainConsole& mainConsole, uint64_t startNs, uint64_t startTick){
+	BatchResult result;
+	result.finished = mainConsole.finishedCount.load();
+	uint64_t lastFinish = mainConsole.lastFinishNs.load();
+	uint64_t lastFinishTick = mainConsole.lastFinishTick.load();
+	if(result.finished > 0 && lastFinish > startNs) result.makespan = (lastFinish - startNs) / 1e9;
+	if(result.finished > 0 && lastFinishTick > startTick) result.makespanTicks = lastFinishTick - startTick;
+	result.throughput = (result.makespan > 0) ? result.finished / result.makespan : 0;
+	{
+		lockStat::Lock lock(mainConsole.queueMutex, "collectBatchResult");
+		mainConsole.clock.Settle(); //virtual time: cores that sat idle at the end haven't counted it yet
+	}
+	VMStat stats = collectVMStat(mainConsole.memManager, mainConsole.coreStates, mainConsole.schedulerTicks);
+	result.utilization = CpuUtilization(stats);
+	result.contextSwitches = stats.contextSwitches;
+	result.wait = mainConsole.latencies.Summarize(latency::Wait);
+	result.turnaround = mainConsole.latencies.Summarize(latency::Turnaround);
+	return result;
+}
+
+// Makespan (batch start to the last process finishing), throughput and utilization, then the latency table.
+static void printBatchSummary(MainConsole& mainConsole, uint64_t startNs, uint64_t startTick){
+	BatchResult result = collectBatchResult(mainConsole, startNs, startTick);
+
+	cout << "===========================================================" << endl;
+	cout << "Batch summary" << endl;
+	cout << "Processes finished: " << result.finished << endl;
+	cout << "Makespan: " << std::fixed << std::setprecision(3) << result.makespan << " s (" << result.makespanTicks << " ticks per core)" << endl;
+	cout << "Throughput: " << result.throughput << " processes/s" << endl;
+	cout << "CPU utilization: " << result.utilization << "%" << endl;
+	cout << "Context switches: " << result.contextSwitches << endl;
+	cout << std::defaultfloat;
+	mainConsole.latencies.Print(cout);
+	cout << "===========================================================" << endl;
+}
+
+// --sweep <grid>: runs the --batch script once for every combination of the grid's values, each run on a MainConsole of
+// its own, as many at a time as the host has cores (or --jobs), then prints one table of the results. The grid is config
+// lines with any number of values, applied on top of the --config file:
+//   quantum-cycles 2 5 10
+//   num-cpu 2 4
+//   allocator paging contiguous
+// Runs only compare if they get the same processes, so drive the batch from a recorded workload (workload replay): every
+// run then sees the same processes arrive at the same virtual tick. Run n keeps its archive, snapshots and default
+// report-util files in sweep-<n>-*. Runs go in virtual time (virtualClock.h): nothing sleeps delays-per-exec, the cores
+// run as fast as the host lets them and processes arrive by tick, so ticks/core is what to compare. The seconds columns
+// and the latencies are host time, which only says how long the sweep itself took. Timed batch lines are still in ms.
+struct SweepAxis {
+	string key;
+	vector<string> values;
+};
+
+static bool loadSweepGrid(const char* path, const Config& base, vector<SweepAxis>& axes){
+	std::ifstream grid(path);
+	if(!grid){
+		std::cerr << "Error opening sweep grid " << path << std::endl;
+		return false;
+	}
+	string line;
+	while(std::getline(grid, line)){
+		line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+		std::istringstream words(line);
+		SweepAxis axis;
+		if(!(words >> axis.key)) continue;
+		string value;
+		while(words >> value){
+			Config check = base;
+			if(const char* error = setConfigValue(check, axis.key.c_str(), value.c_str())){
+				std::cerr << "Sweep grid: " << axis.key << " " << value << ": " << error << std::endl;
+				return false;
+			}
+			axis.values.push_back(value);
+		}
+		if(axis.values.empty()){
+			std::cerr << "No values for " << axis.key << " in sweep grid" << std::endl;
+			return false;
+		}
+		axes.push_back(axis);
+	}
+	return true;
+}
+
+// Discards the runs' console output while the sweep is going, the table goes out once they're all done.
+class NullBuffer : public std::streambuf {
+	protected:
+		int overflow(int c) override { return traits_type::not_eof(c); }
+		std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static int runSweep(const char* gridPath, const char* configPath, const char* batchPath, int jobs){
+	Config base = configSetup(configPath);
+	vector<SweepAxis> axes;
+	if(!loadSweepGrid(gridPath, base, axes)) return EXIT_FAILURE;
+
+	// Every combination, the last axis changing fastest
+	size_t total = 1;
+	for(auto& axis : axes) total *= axis.values.size();
+	vector<vector<string>> settings(total);
+	vector<Config> configs(total, base);
+	for(size_t run = 0; run < total; run++){
+		size_t rest = run;
+		for(size_t a = axes.size(); a-- > 0;){
+			const string& value = axes[a].values[rest % axes[a].values.size()];
+			rest /= axes[a].values.size();
+			setConfigValue(configs[run], axes[a].key.c_str(), value.c_str());
+			settings[run].insert(settings[run].begin(), value);
+		}
+		if(strcmp(configs[run].scheduler, "fcfs") != 0 && strcmp(configs[run].scheduler, "rr") != 0){
+			std::cerr << "Unknown scheduler in sweep: " << configs[run].scheduler << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if(jobs <= 0) jobs = (int)std::max(std::thread::hardware_concurrency(), 1u);
+	jobs = (int)std::min<size_t>(jobs, total);
+	std::cerr << "Sweeping " << total << " configurations, " << jobs << " at a time" << std::endl;
+
+	NullBuffer discard;
+	std::streambuf* console = cout.rdbuf(&discard);
+
+	vector<BatchResult> results(total);
+	vector<char> ok(total, 0);
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> done{0};
+	std::mutex progressMutex;
+	vector<thread> workers;
+	for(int j = 0; j < jobs; j++){
+		workers.emplace_back([&]{
+			for(size_t run = next++; run < total; run = next++){
+				std::unique_ptr<MainConsole> mainConsole(newMainConsole(configs[run], "sweep-" + std::to_string(run) + "-"));
+				mainConsole->clock.SetVirtual(true);
+				std::thread sched = startScheduler(*mainConsole, configs[run]);
+				uint64_t startNs = latency::NowNs();
+				uint64_t startTick = mainConsole->virtualTick();
+				ok[run] = runBatch(*mainConsole, batchPath, startNs);
+				results[run] = collectBatchResult(*mainConsole, startNs, startTick);
+				mainConsole->shutdown();
+				if(sched.joinable()) sched.join();
+
+				std::lock_guard<std::mutex> lock(progressMutex);
+				std::cerr << "[" << ++done << "/" << total << "]";
+				for(size_t a = 0; a < axes.size(); a++) std::cerr << " " << axes[a].key << "=" << settings[run][a];
+				std::cerr << std::endl;
+			}
+		});
+	}
+	for(auto& worker : workers) worker.join();
+	cout.rdbuf(console);
+
+	vector<size_t> widths;
+	for(size_t a = 0; a < axes.size(); a++){
+		size_t width = axes[a].key.size();
+		for(auto& value : axes[a].values) width = std::max(width, value.size());
+		widths.push_back(width + 2);
+	}
+	auto ms = [](uint64_t ns){ return ns / 1e6; };
+	cout << std::left;
+	for(size_t a = 0; a < axes.size(); a++) cout << std::setw(widths[a]) << axes[a].key;
+	cout << std::right << std::setw(9) << "finished" << std::setw(12) << "makespan s" << std::setw(12) << "ticks/core"
+	     << std::setw(12) << "proc/s" << std::setw(8) << "util %" << std::setw(10) << "switches"
+	     << std::setw(13) << "wait p50 ms" << std::setw(13) << "wait p99 ms" << std::setw(13) << "turn p99 ms" << endl;
+	cout << std::fixed << std::setprecision(3);
+	bool allOk = true;
+	for(size_t run = 0; run < total; run++){
+		const BatchResult& r = results[run];
+		cout << std::left;
+		for(size_t a = 0; a < axes.size(); a++) cout << std::setw(widths[a]) << settings[run][a];
+		cout << std::right << std::setw(9) << r.finished << std::setw(12) << r.makespan << std::setw(12) << r.makespanTicks
+		     << std::setw(12) << r.throughput << std::setw(8) << std::setprecision(1) << r.utilization << std::setprecision(3)
+		     << std::setw(10) << r.contextSwitches << std::setw(13) << ms(r.wait.p50) << std::setw(13) << ms(r.wait.p99)
+		     << std::setw(13) << ms(r.turnaround.p99);
+		if(!ok[run]){
+			cout << "  (batch failed)";
+			allOk = false;
+		}
+		cout << endl;
+	}
+	cout << std::defaultfloat;
+	return allOk ? 0 : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]){
+	const char* configPath = "config.txt";
+	const char* batchPath = NULL;
+	const char* sweepPath = NULL;
+	int jobs = 0;
+	auto usage = [&]{
+		std::cerr << "usage: " << argv[0] << " [--config <file>] [--batch <script> [--sweep <grid> [--jobs <n>]]]" << std::endl;
+		return EXIT_FAILURE;
+	};
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--config") == 0 && i + 1 < argc) configPath = argv[++i];
+		else if(strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batchPath = argv[++i];
+		else if(strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) sweepPath = argv[++i];
+		else if(strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = atoi(argv[++i]);
+		else return usage();
+	}
+	if(sweepPath != NULL){
+		if(batchPath == NULL) return usage(); //the sweep runs the batch script once per configuration
+		return runSweep(sweepPath, configPath, batchPath, jobs);
+	}
+
+	if(batchPath == NULL && !startScreen()) //Start the screen to prompt the user to initialize the program
+		return 0;
 
 
-	std::thread sched;
 	//file reading should be done here
-	Config config = configSetup(); //This should read the config file and set the values accordingly
-    MainConsole mainConsole(config.num_cpu, config.scheduler, config.quantum_cycles, 
-                            config.batch_process_freq, config.min_ins, 
-                            config.max_ins, config.delay_per_exec,
-                            config.max_overall_mem, config.mem_per_frame, config.min_mem_per_proc, config.max_mem_per_proc);
+	Config config = configSetup(configPath); //This should read the config file and set the values accordingly
+	std::unique_ptr<MainConsole> owner(newMainConsole(config));
+	MainConsole& mainConsole = *owner;
+	mainConsole.configPath = configPath; //for config reload
 	//MainConsole mainConsole(NUM_CPU, SCHEDULER, QUANTUM_CYCLES, BATCH_PROCESS_FREQ, MIN_INS, MAX_INS, DELAY_PER_EXEC);
 	Console* console = &mainConsole; //holds the current active console, initialized to main Menu as it's the root
 	Console* temp = NULL;
@@ -131,18 +398,15 @@ int main(){
 	
 
     // Start scheduler
-	int processes = 0;
-
+	std::thread sched = startScheduler(mainConsole, config);
 
-	if (strcmp(config.scheduler,"fcfs" )== 0) {
-		cout << "Using FCFS scheduler." << endl;
-		sched = thread(&MainConsole::FCFSscheduler, &mainConsole, ref(processes));
-
-	} else if (strcmp(config.scheduler,"rr" )== 0) {
-		cout << "Using Round Robin scheduler." << endl;
-		sched = thread(&MainConsole::rrscheduler, &mainConsole, ref (processes));
-	} else {
-		std :: cerr << "Unknown scheduler in config.txt: " << config.scheduler << endl;
+	uint64_t batchStartNs = latency::NowNs();
+	uint64_t batchStartTick = mainConsole.virtualTick();
+	bool batchOk = true;
+	if(batchPath != NULL){
+		batchOk = runBatch(mainConsole, batchPath, batchStartNs);
+		if(batchOk) printBatchSummary(mainConsole, batchStartNs, batchStartTick);
+		mainConsole.exit = true; //skip the interactive loop
 	}
 
 	while(!(console->exit)){ //========This should be a thread by itself
@@ -151,12 +415,18 @@ int main(){
 		else
 			cout << path << console->process.pname << "/>";
 
-		std::getline(cin, input);
-		console->handleInput(input);
+		if(!std::getline(cin, input)) break; //input closed, same as exit
+		if(console->mainConsole)
+			console->handleInput(input);
+		else{
+			lockStat::Lock lock(mainConsole.processStatusMutex, "main: screen input"); //cores update the attached console under this lock
+			console->handleInput(input);
+		}
 		if(console->handoff != NULL){
 			temp = console->handoff;
 			console->handoff = NULL; //switch the handoff back to null
 			console = temp; //switch the current console to the handoff value
+			lockStat::Lock lock(mainConsole.processStatusMutex, "main: screen switch");
 			console->clear();
 		}
 		else if(console->exit && !(console->mainConsole)){
@@ -167,56 +437,9 @@ int main(){
 		std::this_thread::sleep_for(milliseconds(1)); 
 	}
 
-	// Detach the threads so we don't wait on them because they have while(true) loops
-	sched.detach();
-    for (auto& t : mainConsole.cores) t.detach();
+	// Stop and join every thread before mainConsole goes away
+	mainConsole.shutdown();
+	if (sched.joinable()) sched.join();
 
-    return 0;
+    return batchOk ? 0 : EXIT_FAILURE;
 }
-
-// Implementation for continuous process generation
-void MainConsole::startProcessGenerator(int i, string s, int mem) {
-    if (generatingProcesses) {
-        std::cout << "Process generator already running.\n";
-        return;
-    }
-    generatingProcesses = true;
-    processGeneratorThread = std::thread(&MainConsole::processGeneratorLoop, this, i, s, mem);
-    std::cout << "[scheduler -start] Process generator started.\n";
-}
-
-void MainConsole::stopProcessGenerator() {
-    if (!generatingProcesses) {
-        std::cout << "Process generator is not running.\n";
-        return;
-    }
-    generatingProcesses = false;
-    if (processGeneratorThread.joinable()) {
-        processGeneratorThread.join();
-    }
-    std::cout << "[scheduler -stop] Process generator stopped.\n";
-}
-
-void MainConsole::processGeneratorLoop(int i, string s, int mem) {
-    int numLoops = 0;
-    while (generatingProcesses && (numLoops < i || i == 0)) {
-        Console console;
-        consoleMade++;
-        if(i != 0)
-            console.process = Process(s, consoleMade, minIns, maxIns, mem);
-        else
-            console.process = Process("process_" + std::to_string(consoleMade), consoleMade, minIns, maxIns, minMemPerProc, maxMemPerProc);
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            processQueue.push_back(console);
-            //if(i != 0) this->handoff = &processQueue.back();
-        }
-        cv.notify_one();
-        if(i != 0) numLoops++;
-        //if(numLoops >= i && i != 0){
-        //    generatingProcesses = false;
-        //}
-
-        std::this_thread::sleep_for(milliseconds(batchProcessFreq));
-    }
-}
\ No newline at end of file
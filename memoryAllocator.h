@@ -15,7 +15,18 @@
 #include <iomanip>
 #include "process.h"
 #include <set>
+#include <memory>
 #include "frame.h"
+#include "pageReplacement.h"
+#include "tlb.h"
+#include "physicalMemory.h"
+#include "wallClock.h"
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
 
 using std::vector;
 using std::map;
@@ -31,24 +42,14 @@ namespace memoryAllocator {
 
 	// helper function to get timestamp
 string getCurrentTimestamp() {
-    std::time_t now = std::time(nullptr);
-    char buffer[64];
-    std::strftime(buffer, sizeof(buffer), "%m/%d/%Y %I:%M:%S%p", std::localtime(&now));
-    return string(buffer);
+    return wallClock::Now(wallClock::Log);
 }
 
 
-void writeMemorySnapshot(int quantumCycle, const vector<Frame>& frames, int memPerFrame) {
-    string filename = "memory_stamp_" + std::to_string(quantumCycle) + ".txt";
-    ofstream file(filename);
-    cout << "writing to file" << endl;
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open " << filename << " for writing.\n";
-        return;
-    }
-
+// Memory map in the memory_stamp_<N>.txt layout. Shared by writeMemorySnapshot and the snapshot-read command.
+inline void printMemorySnapshot(std::ostream& file, const vector<Frame>& frames, const string& timestamp) {
     // Timestamp
-    file << "Timestamp: (" << getCurrentTimestamp() << ")" << endl;
+    file << "Timestamp: (" << timestamp << ")" << endl;
 
     // Count unique processes
     std::set<string> activeProcesses;
@@ -115,6 +116,17 @@ void writeMemorySnapshot(int quantumCycle, const vector<Frame>& frames, int memP
     }
 
     file << "----start---- = 0" << endl;
+}
+
+void writeMemorySnapshot(int quantumCycle, const vector<Frame>& frames, int memPerFrame) {
+    string filename = "memory_stamp_" + std::to_string(quantumCycle) + ".txt";
+    ofstream file(filename);
+    cout << "writing to file" << endl;
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << filename << " for writing.\n";
+        return;
+    }
+    printMemorySnapshot(file, frames, getCurrentTimestamp());
     file.close();
 }
 
@@ -124,10 +136,20 @@ void writeMemorySnapshot(int quantumCycle, const vector<Frame>& frames, int memP
         int maxMemory;
         int numFrames;
         int memoryPerFrame;
-        vector<Frame> frames;
+        vector<Frame> frames;   //guarded by frameTableMutex, use SnapshotFrames() to read from outside
+
+        std::unique_ptr<pageReplacement::ReplacementPolicy> policy; //Picks victims when frames run out. "none" never evicts. Fixed at construction, cores use it unlocked
+        std::atomic<uint64_t> pagedIn{0};
+        std::atomic<uint64_t> pagedOut{0};
 
-        // Constructor with initialization
-        MemoryAllocator(int maxOverallMemory, int memPerFrame)
+        physicalMemory::Arena ram; //the bytes behind every frame, READ/WRITE load and store here directly
+
+        bool contiguous = false;   //allocator in config.txt: "contiguous" admits with AllocateProcessContiguous, "paging" (default) with AllocateProcess
+        std::atomic<uint64_t> compactions{0};  //compaction passes that moved at least one frame
+        std::atomic<uint64_t> framesMoved{0};  //frames relocated by compaction
+
+        // Constructor with initialization. replacementPolicy is fifo, clock, lru, arc or none, and can't change afterwards.
+        MemoryAllocator(int maxOverallMemory, int memPerFrame, string replacementPolicy = "none")
             : maxMemory(maxOverallMemory),
               memoryPerFrame(memPerFrame)
         {
@@ -144,84 +166,602 @@ void writeMemorySnapshot(int quantumCycle, const vector<Frame>& frames, int memP
                 f.pid = "";
                 frames.push_back(f);
             }
+            owners.assign(numFrames, nullptr);
+            policy = pageReplacement::MakePolicy(replacementPolicy, numFrames);
+            evicting = policy->Name() != "none";
+            ram.Map((size_t)numFrames * memoryPerFrame);
+            SetShards(1);
         }
 
         // Default constructor
-        MemoryAllocator() {}
+        MemoryAllocator() : maxMemory(0), numFrames(0), memoryPerFrame(1) {
+            policy = pageReplacement::MakePolicy("none", 0);
+            SetShards(1);
+        }
 
-        // First-Fit allocation: non-contiguous
-        bool AllocateProcess(process::Process& p) {
-            int numNeededFrames = p.size / memoryPerFrame;
-            int frameCounter = 0;
-            int startFrameId = -1;
+        ~MemoryAllocator() {
+            StopCompactor();
+        }
+
+        // Split the free frames into one shard per core. Call before any core starts allocating.
+        void SetShards(int n) {
+            if (n < 1) n = 1;
+            numShards = n;
+            shards.reset(new FreeShard[n]);
+            global.free.clear();
+            //Each shard gets its own block of frames so first-fit inside a shard stays mostly contiguous.
+            for (int i = 0; i < numFrames; ++i) {
+                if (owners[i] == nullptr) shards[(long long)i * n / numFrames].free.push_back(i);
+            }
+            for (int k = 0; k < n; ++k) std::reverse(shards[k].free.begin(), shards[k].free.end()); //pop_back hands out low ids first
+        }
+
+        int PagesNeeded(process::Process& p) {
+            return (p.size + memoryPerFrame - 1) / memoryPerFrame;
+        }
 
-            list<int> idList;
+        uint64_t UsedFrames() {
+            return usedFrames.load(std::memory_order_relaxed);
+        }
+
+        // Copy of the frame table for reports and snapshots, consistent with respect to allocations.
+        vector<Frame> SnapshotFrames() {
+            std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+            return frames;
+        }
 
-            // Search for free frames
-            for (size_t i = 0; i < frames.size(); ++i) {
-                if (frames[i].pid.empty()) {
-                    frameCounter++;
-                    idList.push_back(i);
-                } 
-                if (frameCounter == numNeededFrames) {
-                    break;
+        // Owner pid of every frame (-1 when free), for the snapshot stream. Pids whose `seen` flag isn't set yet get their name
+        // added to newNames and are marked seen, so names are only recorded once.
+        void OwnerMap(vector<int>& pids, vector<char>& seen, vector<std::pair<int, string>>& newNames) {
+            std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+            pids.resize(numFrames);
+            for (int f = 0; f < numFrames; ++f) {
+                PageTable* owner = owners[f];
+                int pid = owner ? owner->pid : -1;
+                pids[f] = pid;
+                if (pid < 0) continue;
+                if ((size_t)pid >= seen.size()) seen.resize(pid * 2 + 1, 0);
+                if (!seen[pid]) {
+                    seen[pid] = 1;
+                    newNames.push_back({pid, owner->pname});
                 }
             }
+        }
 
-            if (frameCounter == numNeededFrames) {
-                for (int i : idList) {
-                    frames[i].pid = p.pname;
-                    p.frames.push_back(frames[i]);
+        // Non-contiguous allocation. Safe to call from several cores at once: frames come from the caller's shard,
+        // then the global pool, then other shards. Only if all of them run dry does it fall back to eviction.
+        bool AllocateProcess(process::Process& p, int core = 0) {
+            int numNeededFrames = PagesNeeded(p);
+
+            if (numNeededFrames > numFrames) return false; //never fits, even with eviction
+
+            vector<int> ids;
+            ids.reserve(numNeededFrames);
+            TakeFree(core, numNeededFrames, ids);
+
+            std::unique_lock<std::mutex> policyLock(policyMutex, std::defer_lock);
+            if ((int)ids.size() < numNeededFrames) {
+                //Not enough free frames: make room by evicting, unless the policy is "none".
+                if (!evicting) {
+                    GiveBack(core, ids);
+                    return false;
                 }
-                /* For debugging.
-                cout << "Allocated to " << p.pname << " are:" << endl;
-                for(int j : idList){
-                    cout << j << endl;
+                policyLock.lock();
+                while ((int)ids.size() < numNeededFrames) {
+                    int f = EvictFor(pageReplacement::PageKey(p.pid, ids.size()));
+                    if (f == -1) break;
+                    ids.push_back(f);
                 }
-                cout << "-----" << endl;*/
-                return true;
-            } else {
-                return false;
+                if ((int)ids.size() < numNeededFrames) { //policy had nothing left to give up, roll back
+                    policyLock.unlock();
+                    GiveBack(core, ids);
+                    return false;
+                }
+            } else if (evicting) {
+                policyLock.lock();
+            }
+
+            std::sort(ids.begin(), ids.end());
+            Publish(p, ids);
+            if (evicting) {
+                for (int page = 0; page < numNeededFrames; ++page) policy->OnLoad(ids[page], pageReplacement::PageKey(p.pid, page));
             }
+            return true;
         }
 
-        //First-fit allocation: contigouous
+        //First-fit allocation: contigouous. Needs a view of every free frame so it locks all shards.
         bool AllocateProcessContiguous(process::Process& p) {
-            int numNeededFrames = p.size / memoryPerFrame;
+            int numNeededFrames = PagesNeeded(p);
             int frameCounter = 0;
             int startFrameId = -1;
+            vector<int> ids;
+
+            {
+                vector<std::unique_lock<std::mutex>> locks;
+                for (int k = 0; k < numShards; ++k) locks.emplace_back(shards[k].lock);
+                locks.emplace_back(global.lock);
+
+                vector<bool> isFree(numFrames, false);
+                for (int k = 0; k < numShards; ++k)
+                    for (int f : shards[k].free) isFree[f] = true;
+                for (int f : global.free) isFree[f] = true;
+
+                // Search for free frames
+                for (int i = 0; i < numFrames; ++i) {
+                    if (isFree[i]) {
+                        frameCounter++;
+                    } 
+                    else frameCounter = 0; 
+
+                    if (frameCounter == numNeededFrames) {
+                        startFrameId = i - numNeededFrames + 1;
+                        break;
+                    }
+                }
+                if (startFrameId == -1) return false;
+
+                auto inRun = [&](int f) { return f >= startFrameId && f < startFrameId + numNeededFrames; };
+                for (int k = 0; k < numShards; ++k)
+                    shards[k].free.erase(std::remove_if(shards[k].free.begin(), shards[k].free.end(), inRun), shards[k].free.end());
+                global.free.erase(std::remove_if(global.free.begin(), global.free.end(), inRun), global.free.end());
+            }
+
+            for (int i = startFrameId; i < startFrameId + numNeededFrames; ++i) ids.push_back(i);
+            Publish(p, ids);
+            if (evicting) {
+                std::lock_guard<std::mutex> policyLock(policyMutex);
+                for (int page = 0; page < numNeededFrames; ++page) policy->OnLoad(ids[page], pageReplacement::PageKey(p.pid, page));
+            }
+            return true;
+        }
+
+        // Admission entry point for the cores and the scheduler. Uses whichever allocator config.txt picked; a failed contiguous
+        // allocation wakes the compactor so the next try is more likely to find a big enough hole.
+        bool Admit(process::Process& p, int core = 0) {
+            if (!contiguous) return AllocateProcess(p, core);
+            if (AllocateProcessContiguous(p)) return true;
+            RequestCompaction();
+            return false;
+        }
+
+        // External fragmentation in percent: how much of the free memory is outside the largest free hole.
+        double Fragmentation() {
+            vector<bool> isFree = FreeMap();
+            int totalFree = 0, run = 0, largest = 0;
+            for (bool f : isFree) {
+                if (f) {
+                    totalFree++;
+                    run++;
+                    largest = std::max(largest, run);
+                } else run = 0;
+            }
+            return (totalFree > 0) ? (1.0 - (double)largest / totalFree) * 100.0 : 0;
+        }
+
+        // Start the background compactor. It runs when an allocation fails or fragmentation reaches `thresholdPercent`,
+        // moving at most `batch` frames per step so allocations and page faults can get in between steps.
+        void StartCompactor(double thresholdPercent, int batch = 16) {
+            StopCompactor();
+            compactionThreshold = thresholdPercent;
+            compactionBatch = std::max(1, batch);
+            compactorRunning = true;
+            compactor = std::thread(&MemoryAllocator::CompactorLoop, this);
+        }
 
-            // Search for free frames
-            for (size_t i = 0; i < frames.size(); ++i) {
-                if (frames[i].pid.empty()) {
-                    frameCounter++;
-                } 
-                else frameCounter = 0; 
+        void StopCompactor() {
+            {
+                std::lock_guard<std::mutex> lock(compactorMutex);
+                compactorRunning = false;
+            }
+            compactorCv.notify_all();
+            if (compactor.joinable()) compactor.join();
+        }
+
+        void RequestCompaction() {
+            {
+                std::lock_guard<std::mutex> lock(compactorMutex);
+                compactionRequested = true;
+            }
+            compactorCv.notify_one();
+        }
+
+        // One bounded compaction step: slide up to `batch` used frames down into the lowest holes. Returns how many moved,
+        // 0 once every used frame sits below every free one. Page tables are updated in place, so every copy of a
+        // process sees its new frames; TLB entries for the old frames fail validation and get refilled.
+        int CompactStep(int batch) {
+            std::lock_guard<std::mutex> policyLock(policyMutex);
+            std::unique_lock<std::shared_mutex> lock(frameTableMutex);
+            vector<std::unique_lock<std::mutex>> shardLocks;
+            for (int k = 0; k < numShards; ++k) shardLocks.emplace_back(shards[k].lock);
+            shardLocks.emplace_back(global.lock);
+
+            vector<bool> isFree(numFrames, false);
+            for (int k = 0; k < numShards; ++k)
+                for (int f : shards[k].free) isFree[f] = true;
+            for (int f : global.free) isFree[f] = true;
+
+            //Frames taken off a free list but not mapped yet are neither holes nor movable, so they are skipped.
+            vector<int> framesFreed;
+            int hole = 0, moved = 0;
+            for (int f = 0; f < numFrames && moved < batch; ++f) {
+                while (hole < numFrames && !isFree[hole]) hole++;
+                if (hole >= numFrames) break;
+                if (f <= hole || owners[f] == nullptr) continue;
+
+                MoveFrame(f, hole);
+                isFree[hole] = false;
+                isFree[f] = true;
+                framesFreed.push_back(f);
+                moved++;
+            }
+            if (moved == 0) return 0;
+
+            //Filled holes leave whatever list they were on; moved-from frames that are still empty become the new holes.
+            auto wasFilled = [&](int f) { return !isFree[f]; };
+            for (int k = 0; k < numShards; ++k)
+                shards[k].free.erase(std::remove_if(shards[k].free.begin(), shards[k].free.end(), wasFilled), shards[k].free.end());
+            global.free.erase(std::remove_if(global.free.begin(), global.free.end(), wasFilled), global.free.end());
+            for (int f : framesFreed) {
+                if (isFree[f]) global.free.push_back(f);
+            }
 
-                if (frameCounter == numNeededFrames) {
-                    startFrameId = static_cast<int>(i) - numNeededFrames + 1;
-                    break;
+            framesMoved += moved;
+            return moved;
+        }
+
+        // Touch a virtual address of an admitted process. Returns the frame holding it, faulting the page in if it was evicted. -1 if the address is outside the process or no frame could be found.
+        int AccessAddress(process::Process& p, int vaddr, int core = 0) {
+            if (!p.pageTable || vaddr < 0) return -1;
+            PageTable& table = *p.pageTable;
+            int page = vaddr / memoryPerFrame;
+            if (page >= table.numPages) return -1;
+
+            int f;
+            {
+                std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+                if (table.released) return -1;
+                f = table.FrameOf(page);
+            }
+            if (f != -1) {
+                NoteHit(f);
+                return f;
+            }
+
+            //Page fault. Faults only happen once something was evicted, so serializing them on the policy lock is fine.
+            std::lock_guard<std::mutex> policyLock(policyMutex);
+            {
+                std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+                if (table.released) return -1;
+                f = table.FrameOf(page);
+            }
+            if (f != -1) { //someone else faulted it in while we waited
+                policy->hits++;
+                policy->OnAccess(f);
+                return f;
+            }
+
+            policy->faults++;
+            vector<int> got;
+            TakeFree(core, 1, got);
+            f = got.empty() ? EvictFor(pageReplacement::PageKey(table.pid, page)) : got[0];
+            if (f == -1) return -1;
+            {
+                std::unique_lock<std::shared_mutex> lock(frameTableMutex);
+                MapPage(table, page, f);
+            }
+            policy->OnLoad(f, pageReplacement::PageKey(table.pid, page));
+            RestorePage(table.pid, page, f);
+            usedFrames++;
+            pagedIn++;
+            return f;
+        }
+
+        // Virtual to physical translation for READ/WRITE. Checks the core's TLB first, walks the page table on a miss.
+        // Returns the physical byte address, or -1 if the address is outside the process or the page couldn't be brought in.
+        int Translate(process::Process& p, int vaddr, tlb::TLB* cache, int core = 0) {
+            if (!p.pageTable || vaddr < 0) return -1;
+            int page = vaddr / memoryPerFrame;
+            int offset = vaddr % memoryPerFrame;
+
+            int f;
+            if (cache != nullptr && cache->Lookup(p.pid, page, f)) {
+                //Entries aren't shot down on eviction, so make sure the frame still holds this page.
+                bool valid;
+                {
+                    std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+                    valid = owners[f] == p.pageTable.get() && frames[f].page == page;
+                }
+                if (valid) {
+                    cache->NoteHit();
+                    NoteHit(f);
+                    return f * memoryPerFrame + offset;
+                }
+                cache->Invalidate(p.pid, page);
+            }
+            if (cache != nullptr) cache->NoteMiss(); //not cached, or cached but stale
+
+            f = AccessAddress(p, vaddr, core);
+            if (f == -1) return -1;
+            if (cache != nullptr) cache->Insert(p.pid, page, f);
+            return f * memoryPerFrame + offset;
+        }
+
+        // READ/WRITE of a uint16 at vaddr. A translation can go stale before the bytes are touched (another core evicts the
+        // frame, the compactor moves the page), so the access happens here under frameTableMutex, after checking the frame
+        // still holds the page. False if the address can't be mapped.
+        bool Read16(process::Process& p, int vaddr, tlb::TLB* cache, int core, uint16_t& value) {
+            return Access16(p, vaddr, cache, core, [&](size_t paddr) { value = ram.Load16(paddr); });
+        }
+
+        bool Write16(process::Process& p, int vaddr, uint16_t value, tlb::TLB* cache, int core) {
+            return Access16(p, vaddr, cache, core, [&](size_t paddr) { ram.Store16(paddr, value); });
+        }
+
+        // Called once per quantum so aging policies can shift their counters.
+        void Tick() {
+            if (!evicting) return;
+            std::lock_guard<std::mutex> policyLock(policyMutex);
+            policy->Tick();
+        }
+
+        // Frees go back to the caller's shard, so a core that keeps admitting and finishing reuses its own frames.
+        void DeallocateProcess(process::Process& p, int core = 0) {
+            if (p.pageTable) {
+                vector<int> ids;
+                std::unique_lock<std::mutex> policyLock(policyMutex, std::defer_lock);
+                if (evicting) policyLock.lock();
+                {
+                    std::unique_lock<std::shared_mutex> lock(frameTableMutex);
+                    Release(*p.pageTable, ids);
+                    tables.erase(p.pageTable->pid);
+                }
+                if (policyLock.owns_lock()) policyLock.unlock();
+                usedFrames -= ids.size();
+                GiveBack(core, ids);
+            }
+        }
+
+    private:
+        struct FreeShard {
+            std::mutex lock;
+            vector<int> free;   //free frame ids, lowest id at the back
+        };
+
+        vector<PageTable*> owners;                  //page table that each frame belongs to, nullptr when free
+        map<int, std::shared_ptr<PageTable>> tables; //every admitted process by pid, keeps the tables alive until deallocation
+        std::unordered_map<uint64_t, vector<uint8_t>> swap; //contents of evicted pages, keyed by PageKey(pid, page). Guarded by policyMutex.
+
+        // Lock order: policyMutex -> frameTableMutex -> shard locks.
+        std::mutex policyMutex;              //policy state, swap and evictions
+        std::shared_mutex frameTableMutex;   //frames, owners, tables and page table extents
+        std::unique_ptr<FreeShard[]> shards;
+        int numShards = 1;
+        FreeShard global;                    //overflow from shards that got too full, first place a dry shard looks
+        bool evicting = false;               //policy is anything but "none", set once by the constructor
+        std::atomic<uint64_t> usedFrames{0};
+
+        std::thread compactor;
+        std::mutex compactorMutex;
+        std::condition_variable compactorCv;
+        std::atomic<bool> compactorRunning{false};
+        bool compactionRequested = false;
+        double compactionThreshold = 0;
+        int compactionBatch = 16;
+
+        vector<bool> FreeMap() {
+            vector<std::unique_lock<std::mutex>> locks;
+            for (int k = 0; k < numShards; ++k) locks.emplace_back(shards[k].lock);
+            locks.emplace_back(global.lock);
+            vector<bool> isFree(numFrames, false);
+            for (int k = 0; k < numShards; ++k)
+                for (int f : shards[k].free) isFree[f] = true;
+            for (int f : global.free) isFree[f] = true;
+            return isFree;
+        }
+
+        void CompactorLoop() {
+            while (true) {
+                bool requested;
+                {
+                    std::unique_lock<std::mutex> lock(compactorMutex);
+                    compactorCv.wait_for(lock, std::chrono::milliseconds(10), [this] { return !compactorRunning || compactionRequested; });
+                    if (!compactorRunning) return;
+                    requested = compactionRequested;
+                    compactionRequested = false;
+                }
+                if (!requested && Fragmentation() < compactionThreshold) continue;
+                int pass = 0, moved;
+                //Step until memory is packed, yielding between steps so nobody waits on us for long.
+                while ((moved = CompactStep(compactionBatch)) > 0) {
+                    pass += moved;
+                    std::this_thread::yield();
+                    if (!compactorRunning) return;
                 }
+                if (pass > 0) compactions++;
             }
+        }
 
-            if (startFrameId != -1) {
-                for (int i = startFrameId; i < startFrameId + numNeededFrames; ++i) {
-                    frames[i].pid = p.pname;
-                    p.frames.push_back(frames[i]);
+        // Translate, then run access on the physical address with frameTableMutex held, provided the frame still holds the
+        // page. Eviction and compaction remap under the exclusive lock, so they can't slip in between. If the page moved
+        // after translating, translate again.
+        template <class Access>
+        bool Access16(process::Process& p, int vaddr, tlb::TLB* cache, int core, Access access) {
+            if (vaddr < 0 || vaddr % memoryPerFrame > memoryPerFrame - 2) return false; //a uint16 can't straddle two frames
+            int page = vaddr / memoryPerFrame;
+            for (int attempt = 0; attempt < 4; ++attempt) {
+                int paddr = Translate(p, vaddr, cache, core);
+                if (paddr < 0) return false;
+                int f = paddr / memoryPerFrame;
+                std::shared_lock<std::shared_mutex> lock(frameTableMutex);
+                if (owners[f] == p.pageTable.get() && frames[f].page == page) {
+                    access((size_t)paddr);
+                    return true;
                 }
-                return true;
+            }
+            return false;
+        }
+
+        // Relocate a mapped frame's page and bytes into a free frame. Caller holds policyMutex and frameTableMutex exclusively.
+        void MoveFrame(int from, int to) {
+            PageTable* owner = owners[from];
+            int page = frames[from].page;
+            memcpy(ram.At((size_t)to * memoryPerFrame), ram.At((size_t)from * memoryPerFrame), memoryPerFrame);
+
+            frames[to].pid = frames[from].pid;
+            frames[to].page = page;
+            owners[to] = owner;
+            owner->SetPage(page, to);
+
+            frames[from].pid.clear();
+            frames[from].page = -1;
+            owners[from] = nullptr;
+
+            if (evicting) {
+                policy->OnFree(from);
+                policy->OnLoad(to, pageReplacement::PageKey(owner->pid, page));
+            }
+        }
+
+        // Move up to `want` free frames into `out`: own shard first, then the global pool, then steal from the others.
+        void TakeFree(int core, int want, vector<int>& out) {
+            int home = ((core % numShards) + numShards) % numShards;
+            auto take = [&](FreeShard& s) {
+                std::lock_guard<std::mutex> lock(s.lock);
+                while ((int)out.size() < want && !s.free.empty()) {
+                    out.push_back(s.free.back());
+                    s.free.pop_back();
+                }
+            };
+            take(shards[home]);
+            if ((int)out.size() < want) take(global);
+            for (int k = 1; k < numShards && (int)out.size() < want; ++k) take(shards[(home + k) % numShards]);
+        }
+
+        void GiveBack(int core, vector<int>& ids) {
+            if (ids.empty()) return;
+            int home = ((core % numShards) + numShards) % numShards;
+            size_t cap = 2 * (numFrames / numShards + 1);
+            vector<int> spill;
+            {
+                std::lock_guard<std::mutex> lock(shards[home].lock);
+                vector<int>& free = shards[home].free;
+                for (int f : ids) free.push_back(f);
+                //Keep one shard from hoarding everything; the excess goes where any core can find it.
+                if (free.size() > cap) {
+                    size_t excess = free.size() - cap;
+                    spill.assign(free.begin(), free.begin() + excess);
+                    free.erase(free.begin(), free.begin() + excess);
+                }
+            }
+            if (!spill.empty()) {
+                std::lock_guard<std::mutex> lock(global.lock);
+                for (int f : spill) global.free.push_back(f);
+            }
+        }
+
+        // Build the page table for frames the caller already owns and make it visible to everyone else.
+        // `ids` is sorted, so consecutive frames collapse into a handful of extents.
+        void Publish(process::Process& p, const vector<int>& ids) {
+            std::shared_ptr<PageTable> table = std::make_shared<PageTable>();
+            table->pid = p.pid;
+            table->pname = p.pname;
+            table->numPages = ids.size();
+            for (int f : ids) {
+                int last = table->extents.size() - 1;
+                if (last >= 0 && table->extents[last].firstFrame + table->extents[last].count == f) table->extents[last].count++;
+                else table->extents.push_back({f, 1});
+            }
+            table->resident = ids.size();
+            //New pages start zeroed. Done before mapping while the frames are still ours alone; once mapped the compactor may move them.
+            for (int f : ids) memset(ram.At((size_t)f * memoryPerFrame), 0, memoryPerFrame);
+            {
+                std::unique_lock<std::shared_mutex> lock(frameTableMutex);
+                for (size_t page = 0; page < ids.size(); ++page) {
+                    int f = ids[page];
+                    frames[f].pid = table->pname;
+                    frames[f].page = page;
+                    owners[f] = table.get();
+                }
+                tables[p.pid] = table;
+            }
+            usedFrames += ids.size();
+            pagedIn += ids.size();
+            p.pageTable = table;
+        }
+
+        void NoteHit(int f) {
+            policy->hits++;
+            if (!evicting) return; //"none" keeps no per-frame state
+            std::lock_guard<std::mutex> policyLock(policyMutex);
+            policy->OnAccess(f);
+        }
+
+        // Caller holds frameTableMutex exclusively.
+        void MapPage(PageTable& table, int page, int f) {
+            frames[f].pid = table.pname;
+            frames[f].page = page;
+            owners[f] = &table;
+            table.SetPage(page, f);
+        }
+
+        // Bring back what was paged out, otherwise the page starts zeroed. Caller holds policyMutex.
+        void RestorePage(int pid, int page, int f) {
+            uint8_t* bytes = ram.At((size_t)f * memoryPerFrame);
+            auto saved = swap.find(pageReplacement::PageKey(pid, page));
+            if (saved != swap.end()) {
+                memcpy(bytes, saved->second.data(), memoryPerFrame);
+                swap.erase(saved);
             } else {
-                return false;
+                memset(bytes, 0, memoryPerFrame);
+            }
+        }
+
+        // Caller holds frameTableMutex exclusively (and policyMutex when paging out).
+        void UnmapFrame(int f, bool pageOut = false) {
+            PageTable* owner = owners[f];
+            if (pageOut && owner != nullptr) {
+                uint8_t* bytes = ram.At((size_t)f * memoryPerFrame);
+                swap[pageReplacement::PageKey(owner->pid, frames[f].page)].assign(bytes, bytes + memoryPerFrame);
+            }
+            if (owner != nullptr) owner->SetPage(frames[f].page, -1);
+            frames[f].pid.clear();
+            frames[f].page = -1;
+            owners[f] = nullptr;
+        }
+
+        // Ask the policy for a victim, page it out and hand back the now-free frame. Caller holds policyMutex.
+        int EvictFor(uint64_t incoming) {
+            int victim = policy->PickVictim(incoming);
+            if (victim == -1) return -1;
+            {
+                std::unique_lock<std::shared_mutex> lock(frameTableMutex);
+                UnmapFrame(victim, true);
             }
+            usedFrames--;
+            policy->evictions++;
+            pagedOut++;
+            return victim;
         }
 
-        void DeallocateProcess(process::Process& p) {
-            for (Frame f : p.frames) {
-                if (f.id >= 0 && f.id < frames.size()) {
-                    frames[f.id].pid.clear();
+        // Caller holds frameTableMutex exclusively, and policyMutex if evicting.
+        void Release(PageTable& table, vector<int>& ids) {
+            for (int i = 0, start = 0; i < table.extents.size(); start += table.extents[i].count, ++i) {
+                Extent e = table.extents[i];
+                for (int k = 0; k < e.count; ++k) {
+                    if (e.firstFrame == -1) {
+                        if (evicting) swap.erase(pageReplacement::PageKey(table.pid, start + k));
+                        continue;
+                    }
+                    int f = e.firstFrame + k;
+                    if (evicting) policy->OnFree(f);
+                    frames[f].pid.clear();
+                    frames[f].page = -1;
+                    owners[f] = nullptr;
+                    ids.push_back(f);
                 }
             }
-            p.frames.clear();
+            table.Reset(table.numPages);
+            table.released = true;
         }
     };
 
@@ -0,0 +1,238 @@
+#pragma once
+#ifndef metricsExportH
+#define metricsExportH
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include "config.h"
+
+using std::string;
+
+namespace metricsExport {
+
+#ifdef _WIN32
+	typedef SOCKET Socket;
+	static const Socket invalidSocket = INVALID_SOCKET;
+	inline void closeSocket(Socket s){ closesocket(s); }
+#else
+	typedef int Socket;
+	static const Socket invalidSocket = -1;
+	inline void closeSocket(Socket s){ close(s); }
+#endif
+
+	//http: serve on 127.0.0.1:<port>. unix: serve HTTP on a UNIX socket (curl --unix-socket). file: rewrite a .prom file
+	//(node_exporter textfile collector) every interval, through a temporary file and a rename so readers never see half of it.
+	enum Mode { HTTP, Unix, File };
+
+	//Background thread that hands out whatever render() returns. render runs on this thread, so it must only read
+	//counters that are safe to read without the scheduler's locks.
+	class Exporter {
+		public:
+			~Exporter(){
+				Stop();
+			}
+
+			bool Running(){ return running.load(); }
+			const string& Target(){ return target; }
+
+			bool Start(Mode m, const string& where, int everyMs, std::function<string()> renderFn){
+				Stop();
+				mode = m;
+				target = where;
+				intervalMs = std::max(everyMs, 10);
+				render = renderFn;
+				if(mode != File && !listenOn()) return false;
+				running = true;
+				worker = std::thread(&Exporter::loop, this);
+				return true;
+			}
+
+			void Stop(){
+				{
+					std::lock_guard<std::mutex> lock(wakeMutex);
+					running = false;
+				}
+				wake.notify_all();
+				if(worker.joinable()) worker.join();
+				if(listener != invalidSocket){
+					closeSocket(listener);
+					listener = invalidSocket;
+#ifndef _WIN32
+					if(mode == Unix) unlink(target.c_str());
+#endif
+				}
+			}
+
+		private:
+			Mode mode = File;
+			string target;
+			int intervalMs = 1000;
+			std::function<string()> render;
+			std::atomic<bool> running{false};
+			std::thread worker;
+			std::mutex wakeMutex;
+			std::condition_variable wake;
+			Socket listener = invalidSocket;
+
+			bool listenOn(){
+#ifdef _WIN32
+				static bool started = false;
+				if(!started){
+					WSADATA data;
+					if(WSAStartup(MAKEWORD(2, 2), &data) != 0){
+						std::cerr << "Error: Could not start Winsock.\n";
+						return false;
+					}
+					started = true;
+				}
+#endif
+				if(mode == HTTP){
+					int port = 0;
+					if(!parseInt(target.c_str(), port) || port < 1 || port > 65535){
+						std::cerr << "Error: " << target << " is not a port (1-65535).\n";
+						return false;
+					}
+					listener = socket(AF_INET, SOCK_STREAM, 0);
+					if(listener == invalidSocket) return fail("socket");
+					int yes = 1;
+					setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(yes));
+					sockaddr_in addr;
+					memset(&addr, 0, sizeof(addr));
+					addr.sin_family = AF_INET;
+					addr.sin_port = htons((unsigned short)port);
+					addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);	//local scrapes only
+					if(bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0) return fail("bind 127.0.0.1:" + target);
+				}
+				else{
+#ifdef _WIN32
+					std::cerr << "Error: UNIX socket export is not supported on Windows, use http or file.\n";
+					return false;
+#else
+					sockaddr_un addr;
+					memset(&addr, 0, sizeof(addr));
+					addr.sun_family = AF_UNIX;
+					if(target.size() >= sizeof(addr.sun_path)){
+						std::cerr << "Error: Socket path " << target << " is too long.\n";
+						return false;
+					}
+					strncpy(addr.sun_path, target.c_str(), sizeof(addr.sun_path) - 1);
+					unlink(target.c_str());
+					listener = socket(AF_UNIX, SOCK_STREAM, 0);
+					if(listener == invalidSocket) return fail("socket");
+					if(bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0) return fail("bind " + target);
+#endif
+				}
+				if(listen(listener, 8) != 0) return fail("listen");
+				return true;
+			}
+
+			bool fail(const string& what){
+				std::cerr << "Error: metrics export could not " << what << ".\n";
+				if(listener != invalidSocket) closeSocket(listener);
+				listener = invalidSocket;
+				return false;
+			}
+
+			void loop(){
+				while(running){
+					if(mode == File){
+						writeFile();
+						std::unique_lock<std::mutex> lock(wakeMutex);
+						wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return !running; });
+					}
+					else serveOne();
+				}
+			}
+
+			//True once s has something to read, false after 200ms so Stop doesn't hang.
+			static bool readable(Socket s){
+				fd_set ready;
+				FD_ZERO(&ready);
+				FD_SET(s, &ready);
+				timeval timeout;
+				timeout.tv_sec = 0;
+				timeout.tv_usec = 200 * 1000;
+				return select((int)s + 1, &ready, NULL, NULL, &timeout) > 0;
+			}
+
+			//Waits for a scraper, answers any request with the current metrics. A client that connects and sends
+			//nothing gets dropped after the same 200ms instead of blocking recv (and Stop) forever.
+			void serveOne(){
+				if(!readable(listener)) return;
+				Socket client = accept(listener, NULL, NULL);
+				if(client == invalidSocket) return;
+				if(!readable(client)){
+					closeSocket(client);
+					return;
+				}
+				char request[2048];
+				recv(client, request, sizeof(request), 0);	//request line and headers, every path gets the same answer
+				string body = render();
+				char header[160];
+				int n = snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", body.size());
+				sendAll(client, header, n);
+				sendAll(client, body.data(), body.size());
+				closeSocket(client);
+			}
+
+			void sendAll(Socket s, const char* data, size_t size){
+				while(size > 0){
+#ifdef MSG_NOSIGNAL
+					int sent = send(s, data, (int)size, MSG_NOSIGNAL);	//a scraper hanging up early shouldn't kill the emulator
+#else
+					int sent = send(s, data, (int)size, 0);
+#endif
+					if(sent <= 0) return;
+					data += sent;
+					size -= sent;
+				}
+			}
+
+			void writeFile(){
+				string body = render();
+				string temp = target + ".tmp";
+				FILE* f = fopen(temp.c_str(), "wb");
+				if(f == NULL) return;
+				fwrite(body.data(), 1, body.size(), f);
+				fclose(f);
+#ifdef _WIN32
+				MoveFileExA(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+				rename(temp.c_str(), target.c_str());
+#endif
+			}
+	};
+}
+
+#endif
@@ -0,0 +1,296 @@
+#pragma once
+#ifndef pageReplacementH
+#define pageReplacementH
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <atomic>
+
+using std::string;
+using std::list;
+using std::vector;
+using std::unordered_map;
+
+namespace pageReplacement {
+
+	//Pages are identified by (pid, virtual page) packed into one key so policies like ARC can remember pages that already left memory.
+	inline uint64_t PageKey(int pid, int page){
+		return ((uint64_t)(uint32_t)pid << 32) | (uint32_t)page;
+	}
+
+	//Base class for every replacement policy. The allocator tells the policy what happens to each frame and asks it for a victim when memory is full.
+	class ReplacementPolicy {
+		public:
+			std::atomic<uint64_t> hits{0};		//Accesses to a page that was already resident
+			std::atomic<uint64_t> faults{0};		//Accesses that had to bring a page back in
+			std::atomic<uint64_t> evictions{0};	//Pages this policy chose to kick out
+
+			virtual ~ReplacementPolicy(){}
+
+			virtual string Name() = 0;
+			virtual void OnLoad(int frame, uint64_t key) = 0;	//A page was placed in this frame
+			virtual void OnAccess(int frame) = 0;				//A resident page in this frame was referenced
+			virtual void OnFree(int frame) = 0;					//The frame was released by its owner (not an eviction)
+			virtual int PickVictim(uint64_t incoming) = 0;		//Frame to evict so `incoming` can be loaded, -1 if nothing can go
+			virtual void Tick(){}								//Called once per quantum, used by policies that age
+
+			double HitRate(){
+				uint64_t total = hits + faults;
+				return (total > 0) ? ((double)hits / total) * 100.0 : 0;
+			}
+	};
+
+	//Default when config.txt doesn't pick a policy: pages are never evicted, so admission simply waits for free frames like before.
+	class NoEvictionPolicy : public ReplacementPolicy {
+		public:
+			string Name(){ return "none"; }
+			void OnLoad(int, uint64_t){}
+			void OnAccess(int){}
+			void OnFree(int){}
+			int PickVictim(uint64_t){ return -1; }
+	};
+
+	//First in, first out: evict whatever page has been resident the longest.
+	class FIFOPolicy : public ReplacementPolicy {
+		public:
+			FIFOPolicy(int numFrames) : position(numFrames), loaded(numFrames, false) {}
+
+			string Name(){ return "fifo"; }
+
+			void OnLoad(int frame, uint64_t){
+				if(loaded[frame]) order.erase(position[frame]);
+				order.push_back(frame);
+				position[frame] = std::prev(order.end());
+				loaded[frame] = true;
+			}
+
+			void OnAccess(int){}
+
+			void OnFree(int frame){
+				if(!loaded[frame]) return;
+				order.erase(position[frame]);
+				loaded[frame] = false;
+			}
+
+			int PickVictim(uint64_t){
+				if(order.empty()) return -1;
+				int victim = order.front();
+				OnFree(victim);
+				return victim;
+			}
+
+		private:
+			list<int> order;						//Oldest frame at the front
+			vector<list<int>::iterator> position;	//Where each frame sits in `order`
+			vector<bool> loaded;
+	};
+
+	//CLOCK / second chance: sweep a hand over the frames, clearing reference bits until one is found already cleared.
+	class ClockPolicy : public ReplacementPolicy {
+		public:
+			ClockPolicy(int numFrames) : referenced(numFrames, false), loaded(numFrames, false) {}
+
+			string Name(){ return "clock"; }
+
+			void OnLoad(int frame, uint64_t){
+				loaded[frame] = true;
+				referenced[frame] = true;
+			}
+
+			void OnAccess(int frame){ referenced[frame] = true; }
+
+			void OnFree(int frame){
+				loaded[frame] = false;
+				referenced[frame] = false;
+			}
+
+			int PickVictim(uint64_t){
+				int n = loaded.size();
+				//Two full sweeps is enough: the first clears every reference bit.
+				for(int i = 0; i < 2 * n; i++){
+					int frame = hand;
+					hand = (hand + 1) % n;
+					if(!loaded[frame]) continue;
+					if(referenced[frame]){
+						referenced[frame] = false;
+						continue;
+					}
+					OnFree(frame);
+					return frame;
+				}
+				return -1;
+			}
+
+		private:
+			vector<bool> referenced;
+			vector<bool> loaded;
+			int hand = 0;
+	};
+
+	//LRU approximation by aging: every quantum each counter shifts right and the reference bit is put in the top bit. Lowest counter goes first.
+	class AgingPolicy : public ReplacementPolicy {
+		public:
+			AgingPolicy(int numFrames) : age(numFrames, 0), referenced(numFrames, false), loaded(numFrames, false) {}
+
+			string Name(){ return "lru"; }
+
+			void OnLoad(int frame, uint64_t){
+				loaded[frame] = true;
+				referenced[frame] = true;
+				age[frame] = 0;
+			}
+
+			void OnAccess(int frame){ referenced[frame] = true; }
+
+			void OnFree(int frame){
+				loaded[frame] = false;
+				referenced[frame] = false;
+				age[frame] = 0;
+			}
+
+			void Tick(){
+				for(size_t i = 0; i < age.size(); i++){
+					if(!loaded[i]) continue;
+					age[i] = (age[i] >> 1) | (referenced[i] ? 0x80 : 0);
+					referenced[i] = false;
+				}
+			}
+
+			int PickVictim(uint64_t){
+				int victim = -1;
+				for(size_t i = 0; i < age.size(); i++){
+					if(!loaded[i]) continue;
+					//A page referenced since the last tick counts as newer than any aged page.
+					int score = age[i] | (referenced[i] ? 0x100 : 0);
+					if(victim == -1 || score < (age[victim] | (referenced[victim] ? 0x100 : 0))) victim = i;
+				}
+				if(victim != -1) OnFree(victim);
+				return victim;
+			}
+
+		private:
+			vector<uint8_t> age;
+			vector<bool> referenced;
+			vector<bool> loaded;
+	};
+
+	//Adaptive Replacement Cache (Megiddo & Modha). T1 holds pages seen once, T2 pages seen at least twice, B1/B2 remember what was recently evicted from each so the split `p` can adapt.
+	class ARCPolicy : public ReplacementPolicy {
+		public:
+			ARCPolicy(int numFrames) : capacity(numFrames), keyOf(numFrames, 0), loaded(numFrames, false) {}
+
+			string Name(){ return "arc"; }
+
+			void OnLoad(int frame, uint64_t key){
+				if(loaded[frame]) OnFree(frame);
+				auto ghost = where.find(key);
+				if(ghost != where.end() && ghost->second.first == B1){
+					//Recently evicted from T1: recency is paying off, grow T1's target.
+					int delta = std::max(1, (int)(lists[B2].size() / std::max<size_t>(1, lists[B1].size())));
+					p = std::min(capacity, p + delta);
+					erase(key);
+					insert(T2, key);
+				}
+				else if(ghost != where.end() && ghost->second.first == B2){
+					//Recently evicted from T2: frequency is paying off, shrink T1's target.
+					int delta = std::max(1, (int)(lists[B1].size() / std::max<size_t>(1, lists[B2].size())));
+					p = std::max(0, p - delta);
+					erase(key);
+					insert(T2, key);
+				}
+				else{
+					if(ghost != where.end()) erase(key);
+					insert(T1, key);
+				}
+				frameOf[key] = frame;
+				keyOf[frame] = key;
+				loaded[frame] = true;
+				trimGhosts();
+			}
+
+			void OnAccess(int frame){
+				if(!loaded[frame]) return;
+				uint64_t key = keyOf[frame];
+				erase(key);
+				insert(T2, key);
+			}
+
+			void OnFree(int frame){
+				if(!loaded[frame]) return;
+				uint64_t key = keyOf[frame];
+				erase(key);
+				frameOf.erase(key);
+				loaded[frame] = false;
+			}
+
+			int PickVictim(uint64_t incoming){
+				auto ghost = where.find(incoming);
+				bool inB2 = ghost != where.end() && ghost->second.first == B2;
+				int from;
+				if(!lists[T1].empty() && ((int)lists[T1].size() > p || (inB2 && (int)lists[T1].size() == p)))
+					from = T1;
+				else if(!lists[T2].empty())
+					from = T2;
+				else if(!lists[T1].empty())
+					from = T1;
+				else
+					return -1;
+
+				uint64_t key = lists[from].back(); //LRU end
+				int frame = frameOf[key];
+				erase(key);
+				frameOf.erase(key);
+				loaded[frame] = false;
+				insert(from == T1 ? B1 : B2, key); //Remember it as a ghost
+				trimGhosts();
+				return frame;
+			}
+
+		private:
+			enum { T1 = 0, T2 = 1, B1 = 2, B2 = 3 };
+			int capacity;
+			int p = 0;											//Target size of T1
+			list<uint64_t> lists[4];							//MRU at the front
+			unordered_map<uint64_t, std::pair<int, list<uint64_t>::iterator>> where;
+			unordered_map<uint64_t, int> frameOf;
+			vector<uint64_t> keyOf;
+			vector<bool> loaded;
+
+			void insert(int which, uint64_t key){
+				lists[which].push_front(key);
+				where[key] = {which, lists[which].begin()};
+			}
+
+			void erase(uint64_t key){
+				auto it = where.find(key);
+				if(it == where.end()) return;
+				lists[it->second.first].erase(it->second.second);
+				where.erase(it);
+			}
+
+			void trimGhosts(){
+				//Directory is capped at 2c entries: |T1|+|B1| <= c and the total <= 2c.
+				while(!lists[B1].empty() && lists[T1].size() + lists[B1].size() > (size_t)capacity)
+					erase(lists[B1].back());
+				while(!lists[B2].empty() && lists[T1].size() + lists[T2].size() + lists[B1].size() + lists[B2].size() > (size_t)(2 * capacity))
+					erase(lists[B2].back());
+			}
+	};
+
+	//Builds the policy named in config.txt. "none" (or anything unknown) turns eviction off.
+	inline std::unique_ptr<ReplacementPolicy> MakePolicy(const string& name, int numFrames){
+		if(name == "fifo") return std::unique_ptr<ReplacementPolicy>(new FIFOPolicy(numFrames));
+		if(name == "clock") return std::unique_ptr<ReplacementPolicy>(new ClockPolicy(numFrames));
+		if(name == "lru") return std::unique_ptr<ReplacementPolicy>(new AgingPolicy(numFrames));
+		if(name == "arc") return std::unique_ptr<ReplacementPolicy>(new ARCPolicy(numFrames));
+		return std::unique_ptr<ReplacementPolicy>(new NoEvictionPolicy());
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+#ifndef physicalMemoryH
+#define physicalMemoryH
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace physicalMemory {
+
+	//One contiguous, page-aligned block standing in for the machine's RAM. Frame i owns bytes [i * memPerFrame, (i + 1) * memPerFrame).
+	//Tries huge pages first and falls back to normal pages if the OS won't give us any.
+	class Arena {
+		public:
+			static const size_t pageSize = 4096;
+			static const size_t hugePageSize = 2 * 1024 * 1024;
+
+			uint8_t* base = nullptr;
+			size_t size = 0;			//bytes usable by the emulator (max-overall-mem)
+			size_t mappedSize = 0;		//size rounded up to what was actually mapped
+			bool hugePages = false;
+
+			Arena(){}
+
+			Arena(size_t bytes){
+				Map(bytes);
+			}
+
+			~Arena(){
+				Unmap();
+			}
+
+			Arena(const Arena&) = delete;
+			Arena& operator=(const Arena&) = delete;
+
+			void Map(size_t bytes){
+				Unmap();
+				size = bytes;
+				if(bytes == 0) return;
+
+#ifdef _WIN32
+				mappedSize = roundUp(bytes, hugePageSize);
+				base = (uint8_t*)VirtualAlloc(NULL, mappedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+				hugePages = base != NULL;
+				if(base == NULL){
+					mappedSize = roundUp(bytes, pageSize);
+					base = (uint8_t*)VirtualAlloc(NULL, mappedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+				}
+#else
+				void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+				if(bytes >= hugePageSize){
+					mappedSize = roundUp(bytes, hugePageSize);
+					p = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+					hugePages = p != MAP_FAILED;
+				}
+#endif
+				if(p == MAP_FAILED){
+					mappedSize = roundUp(bytes, pageSize);
+					p = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+					if(p != MAP_FAILED) madvise(p, mappedSize, MADV_HUGEPAGE); //transparent huge pages, if enabled
+#endif
+				}
+				base = (p == MAP_FAILED) ? nullptr : (uint8_t*)p;
+#endif
+				if(base == nullptr){
+					std::cerr << "Error mapping " << bytes << " bytes of emulated memory" << std::endl;
+					size = mappedSize = 0;
+				}
+			}
+
+			uint16_t Load16(size_t paddr){
+				uint16_t v;
+				memcpy(&v, base + paddr, sizeof(v));
+				return v;
+			}
+
+			void Store16(size_t paddr, uint16_t v){
+				memcpy(base + paddr, &v, sizeof(v));
+			}
+
+			//Address can hold a whole uint16 without running off the end.
+			bool InBounds(long paddr){
+				return paddr >= 0 && (size_t)paddr + sizeof(uint16_t) <= size;
+			}
+
+			uint8_t* At(size_t paddr){ return base + paddr; }
+
+		private:
+			static size_t roundUp(size_t n, size_t align){
+				return (n + align - 1) / align * align;
+			}
+
+			void Unmap(){
+				if(base == nullptr) return;
+#ifdef _WIN32
+				VirtualFree(base, 0, MEM_RELEASE);
+#else
+				munmap(base, mappedSize);
+#endif
+				base = nullptr;
+				size = mappedSize = 0;
+				hugePages = false;
+			}
+	};
+}
+
+#endif
@@ -14,7 +14,13 @@
 #include <thread>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <random>
 #include "frame.h"
+#include "processPool.h"
+#include "latency.h"
 
 using std::vector;
 using std::map;
@@ -25,8 +31,6 @@ using std::endl;
 
 namespace process{
 	//#1
-	struct heap{ int i = 1; };			//Template for heap struct.
-	struct stack{ int i = 1; };			//Template for stack struct.
 	struct symbolTableCell{
 		string identifier;  //identifier like varA, varB
 		uint16_t val;		//uint16 value (0, 65,535)
@@ -37,41 +41,65 @@ namespace process{
 	struct library{ int i = 1; };		//Template for  struct.
 	struct instruction{ int i = 1; };	//Template for instruction struct.
 
+	//The generated instructions, back to back in one pooled buffer ('\0' separated). Never changes once built, so every copy
+	//of a Process (queue, running, finished) shares the same one instead of deep-copying a list of strings.
+	struct Program{
+		vector<char, processPool::PoolAllocator<char>> text;
+		vector<uint32_t, processPool::PoolAllocator<uint32_t>> starts;	//where each instruction begins in text
+
+		void Add(const char* s, size_t n){
+			starts.push_back(text.size());
+			text.insert(text.end(), s, s + n);
+			text.push_back('\0');
+		}
+		size_t Size() const { return starts.size(); }
+		const char* At(size_t i) const { return text.data() + starts[i]; }
+	};
+	using LogLines = vector<processPool::String, processPool::PoolAllocator<processPool::String>>;
+
 	class Process{
 		public:
 			int pid; 					//Process ID or PID: Numeric identifier for the process
 			string pname = "error";		//Process Name: (Hopefully) easier-to-understand identifier for the process (i.e. subtraction.exe)
-			time_t startTime; 			//Epoch time when the process was started. time_t is from the <ctime> library.
-			struct tm timestamp;		//Used to hold the time data structure used by <ctime> that's more human-readable.
-			time_t arrivalTime;			//Epoch time when the process arrived
-			struct tm arrivalTimeStamp;	//More human-readable time stamp
-			time_t finishTime;
-			struct tm finishTimeStamp;
-			int core; 					//Indicates which core the process is running on. (i.e. Core 1, Core 2.)
+			time_t startTime = 0; 		//Epoch time when the process was started. time_t is from the <ctime> library.
+			time_t arrivalTime = 0;		//Epoch time when the process arrived
+			time_t finishTime = 0;		//Only ever turned into text for display, see wallClock.h
+			//Nanosecond stamps (latency::NowNs) of each state transition, 0 until it happens. Fed into the latency histograms.
+			uint64_t arrivalNs = 0;		//generated
+			uint64_t admitNs = 0;		//got its memory
+			uint64_t startNs = 0;		//first dispatched to a core
+			uint64_t responseNs = 0;	//first instruction done
+			uint64_t finishNs = 0;
+			int core = -1; 				//Indicates which core the process is running on. (i.e. Core 1, Core 2.)
+			int lastCore = -1;			//Core it ran on most recently, kept after end() resets core.
 			int coreUtil;				//Indicates the utilization of the core. Is a percentage, range is 0 to 100.
 			int lineCount = -1;			//The process' number lines of code.
 			int currLine = 0;			//Which line of code the CPU is currently executing.
-			vector<string> log;			//Log
-			list<string> commands;		//List of commands that the process has to execute.
+			LogLines log;				//Log
+			std::shared_ptr<const Program> program;	//Commands the process has to execute, shared by every copy.
+			size_t nextCommand = 0;		//Index of the next command in program.
+			uint32_t seed = 0;			//What program was generated from, recorded by workload record.
 			symbolTableCell symbolTable[32]; //symbolTable 
 
-			list<Frame> frames;			//List of frames that the process uses.
+			std::shared_ptr<PageTable> pageTable; //Frames the process owns, as (firstFrame, count) extents. Kept up to date by the allocator on eviction and compaction.
 			int size;
 
-			void incrementLine(){ //Function for incrementing current line and the instruction pointer.
+			void incrementLine(){ //Function for incrementing current line.
 				currLine++; 	//Increment the integer counter for line
-				instructions++; //Go the next instruction in the memory.
 			}; 			
 
+			bool HasCommand(){ return program && nextCommand < program->Size(); }
+			const char* CurrentCommand(){ return program->At(nextCommand); }
+			void PopCommand(){ nextCommand++; }
+
 			void start(int coreId){
 				time(&startTime); //Log when the process was started
-				localtime_s(&timestamp, &startTime); //Turn epoch time to calendar time
 				core = coreId;
+				lastCore = coreId;
 			}
 
 			void end(){
 				time(&finishTime);
-				localtime_s(&finishTimeStamp, &finishTime);
 				core = -1;
 			}
 			/*	
@@ -105,72 +133,91 @@ namespace process{
 
 			*/
 			//Process constructors.
-			Process(int instructionCount, int heapSize = 100000, int stackSize = 10000){
+			Process(int instructionCount){
 				time(&startTime); //Log when the process was started
-				localtime_s(&timestamp, &startTime); //Turn epoch time to calendar time
 
 				lineCount = instructionCount; //Set the line count
-
-				//Allocate memory for the instructions/main program
-				instructions = (instruction* )malloc(sizeof(instruction) * instructionCount);
-				if(instructions == NULL) cout << "Error allocating memory for instructions" << endl; 
-					
-				//Allocate memory for the heap
-				pHeap = (heap* )malloc(sizeof(heap) * heapSize);
-				if(pHeap == NULL) cout << "Error allocating memory for the heap" << endl; 
-
-				//Allocate memory for the stack
-				pStack = (stack* )malloc(sizeof(stack) * stackSize);
-				if(pStack == NULL) cout << "Error allocating memory for stack" << endl;
+				//Instructions live in a pooled Program (built by the generator constructor), heap and stack data in the frames handed out by the memory allocator.
 			}	
 
 			Process(string name, int lines, int id){
 				time(&startTime); //Log when the process was started
-				localtime_s(&timestamp, &startTime); //Turn epoch time to calendar time
 				pname = name;
 				pid = id;
 				lineCount = lines;
 			}
 
-			Process(string name, int id) : pname(name), pid(id){
+			Process(string name, int id) : pid(id), pname(name){
 				time(&arrivalTime); //Log when the process was started
-				localtime_s(&arrivalTimeStamp, &arrivalTime); //Turn epoch time to calendar time
+				arrivalNs = latency::NowNs();
 				lineCount = rand() % (200 - 50 + 1) + 50; //picks a random linecount between 50 and 200 UPDATE TO TAKE FROM THE CONFIG INSTEAD
 			}
 
-			Process(string name, int id, int minins, int maxins, int mem = -1, int memmax = -1) : pname(name), pid(id){
+			Process(string name, int id, int minins, int maxins, int mem = -1, int memmax = -1) : pid(id), pname(name){
 				time(&arrivalTime); //Log when the process was started
-				localtime_s(&arrivalTimeStamp, &arrivalTime); //Turn epoch time to calendar time
+				arrivalNs = latency::NowNs();
 
-				if(mem != -1) size = mem; //mem got passed by screen -s/-c
+				if(memmax == -1) size = mem; //mem got passed by screen -s/-c
 				else	size = rand() % (memmax - mem + 1) + mem; //if max memory is passed, assume that mem is min max
 
 				lineCount = rand() % (maxins - minins + 1) + minins; 
+				seed = (uint32_t)rand();
+				generateProgram();
+			}
+
+			//Rebuilds a recorded process (workload replay): size and line count as recorded, the same program from the same seed.
+			Process(uint32_t programSeed, string name, int id, int lines, int mem) : pid(id), pname(name){
+				time(&arrivalTime); //Log when the process was started
+				arrivalNs = latency::NowNs();
+				size = mem;
+				lineCount = lines;
+				seed = programSeed;
+				generateProgram();
+			}
+
+			//Random instruction stream of lineCount lines, drawn from seed alone so the same seed always gives the same program.
+			void generateProgram(){
+				std::minstd_rand rng(seed);
+				auto next = [&rng]{ return (int)(rng() & 0x7fffffff); };
+				//Written straight into the pooled program, no temporary strings per line.
+				std::shared_ptr<Program> code = std::allocate_shared<Program>(processPool::PoolAllocator<Program>());
+				code->starts.reserve(lineCount);
+				code->text.reserve((size_t)lineCount * 24);
+				char line[128];
+				int n;
 					int k = 0;
 				for(int i = 0; i < lineCount; i++){
-					k = rand() % 7;
+					k = next() % 7;
 					switch(k){
 						case 0:
-							commands.push_back("print(Hello World from " + pname + ")");
+							n = snprintf(line, sizeof(line), "print(Hello World from %s)", pname.c_str());
+							code->Add(line, std::min(n, (int)sizeof(line) - 1));
 							break;
 						case 1:
-							commands.push_back("declare var 1");
+							code->Add("declare var 1", 13);
 							break;
 						case 2:
-							commands.push_back("add var1 var2 var3");
+							code->Add("add var1 var2 var3", 18);
 							break;
 						case 3:
-							commands.push_back("subtract var1 var2 var3");
+							code->Add("subtract var1 var2 var3", 23);
 							break;
 						case 4:
-							commands.push_back("sleep(50)");
+							code->Add("sleep(50)", 9);
 							break;
 						case 5:
-							commands.push_back("for([declare(var,value)],3))");
+							code->Add("for([declare(var,value)],3))", 28);
 							break;
+						case 6: {
+							//Touch a random 2-byte aligned address inside the process' memory.
+							int addr = size > 1 ? (next() % (size / 2)) * 2 : 0;
+							n = snprintf(line, sizeof(line), (next() % 2) ? "write var1 0x%x" : "read var1 0x%x", addr);
+							code->Add(line, n);
+							break;
+						}
 						}
 				}
-
+				program = code;
 			}
 
 			Process(){
@@ -178,8 +225,8 @@ namespace process{
 			}; //default Constructor
 
 			void AddToTableUsingIdentifier(string var, string val){
-				for(symbolTableCell stc : symbolTable){
-					if(stc.identifier.empty() && stc.address.empty()){
+				for(symbolTableCell& stc : symbolTable){
+					if(stc.identifier == var || (stc.identifier.empty() && stc.address.empty())){
 						stc.identifier = var;
 						stc.val = static_cast<uint16_t>(std::stoi(val));
 						return;
@@ -189,29 +236,6 @@ namespace process{
 				cout << "[AddUsingId] Oh no" << endl;
 			}
 
-			void ReadFromAddress(string var, string addr){
-				uint16_t value = 0;
-				for(symbolTableCell stc : symbolTable){
-					if(stc.address == addr){
-						value = stc.val;
-					}
-				}
-				UpdateTableUsingIdentifier(var, value);
-			}
-
-			void WriteToAddress(string var, string addr){
-				for(symbolTableCell stc : symbolTable){
-					if(stc.identifier.empty() && stc.address.empty()){
-						stc.address = addr;
-						stc.val = RetrieveValueUsingIdentifier(var);
-						return;
-					}
-				}
-
-				//only reaches here if the add fails
-				cout << "[Write]Oh no" << endl;
-			}
-
 
 			void UpdateTableUsingIdentifier(string var, string val){
 				for(symbolTableCell stc : symbolTable){
@@ -225,7 +249,7 @@ namespace process{
 			}
 
 			void UpdateTableUsingIdentifier(string var, uint16_t i){
-				for(symbolTableCell stc : symbolTable){
+				for(symbolTableCell& stc : symbolTable){
 					if(stc.identifier == var){
 						stc.val = i;
 						return;
@@ -254,19 +278,23 @@ namespace process{
 				UpdateTableUsingIdentifier(dest, RetrieveValueUsingIdentifier(arg1) - RetrieveValueUsingIdentifier(arg2));
 			}
 
+			//Where the current instruction lives, so executing it touches that page. Instructions are 4 bytes and wrap around the process' memory.
+			int InstructionAddress(){
+				if(size <= 0) return 0;
+				return (currLine * 4) % size;
+			}
+
 			int getMemorySize(){
-				return frames.size();
+				if(pageTable) return pageTable->resident.load(std::memory_order_relaxed);
+				return 0;
 			}
 
 			
 
 		private:
-			heap* pHeap;				//Pointer for the heap
-			stack* pStack;				//Pointer for the stack
 			//symbolTable* pSymbolTable;	//Pointer for the symbol table
 			//subroutine* pSubRoutine;	//Pointer for the subroutine
 			//library* libraries;			//Pointer for the libraries
-			instruction* instructions; 	//Pointer for the lines of code/instructions of the process.
 	};
 }
 
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef processArchiveH
+#define processArchiveH
+
+#include <string>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+
+#include "processTable.h"
+
+using std::string;
+
+namespace processArchive {
+
+	//Append-only, tab separated, one finished process per line, times as epoch seconds. Kept across runs.
+	class Archive {
+		public:
+			uint64_t archived = 0;	//records written by this run
+
+			~Archive(){
+				Close();
+			}
+
+			bool Open(const string& filePath){
+				Close();
+				path = filePath;
+				file = fopen(path.c_str(), "a");
+				if(file == NULL){
+					std::cerr << "Error: Could not open " << path << " for appending.\n";
+					return false;
+				}
+				fseek(file, 0, SEEK_END);
+				if(ftell(file) == 0) fprintf(file, "pid\tname\tarrival\tstarted\tfinished\tcurrent line\ttotal lines\n");
+				return true;
+			}
+
+			bool IsOpen(){ return file != NULL; }
+			const string& Path(){ return path; }
+
+			//What's left of a finished process once it falls out of the in-memory window.
+			void Append(const processTable::Row& r){
+				if(file == NULL) return;
+				fprintf(file, "%d\t%s\t%lld\t%lld\t%lld\t%d\t%d\n", r.pid, r.pname.c_str(),
+					(long long)r.arrivalTime, (long long)r.startTime, (long long)r.finishTime, r.currLine, r.lineCount);
+				archived++;
+			}
+
+			//stdio buffers the records, this pushes them out so the file can be read while the emulator runs.
+			void Flush(){
+				if(file) fflush(file);
+			}
+
+			void Close(){
+				if(file) fclose(file);
+				file = NULL;
+			}
+
+		private:
+			string path;
+			FILE* file = NULL;
+	};
+}
+
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+#ifndef processIndexH
+#define processIndexH
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+using std::string;
+
+namespace console {
+    class Console; // Forward declaration of Console class
+}
+
+namespace processIndex {
+
+	enum State { Ready = 0, Running = 1, Finished = 2, Archived = 3 };
+
+	inline const char* StateName(State s){
+		switch(s){
+			case Ready: return "ready";
+			case Running: return "running";
+			case Finished: return "finished";
+			default: return "archived";
+		}
+	}
+
+	//One per process ever created. `view` is a console of its own (not an element of the queues), so a pointer to it stays
+	//valid while the cores move the process between containers. Cores keep it in sync under processStatusMutex.
+	//It's dropped when the process is archived; the entry itself is small enough to keep for every process.
+	struct Entry {
+		int pid = -1;
+		string pname;
+		State state = Ready;
+		std::shared_ptr<console::Console> view;
+	};
+
+	//Name -> pid and pid -> Entry hash maps, split into shards with their own lock so lookups from the UI
+	//don't queue behind the cores updating states. When names repeat (screen -s with the same name), the newest pid wins.
+	class ProcessIndex {
+		public:
+			static const int numShards = 16;
+
+			void Add(int pid, const string& pname, std::shared_ptr<console::Console> view){
+				{
+					Shard& s = pidShard(pid);
+					std::unique_lock<std::shared_mutex> lock(s.mutex);
+					Entry& e = s.byPid[pid];
+					e.pid = pid;
+					e.pname = pname;
+					e.state = Ready;
+					e.view = std::move(view);
+				}
+				{
+					Shard& s = nameShard(pname);
+					std::unique_lock<std::shared_mutex> lock(s.mutex);
+					s.byName[pname] = pid;
+				}
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			bool FindByPid(int pid, Entry& out){
+				Shard& s = pidShard(pid);
+				std::shared_lock<std::shared_mutex> lock(s.mutex);
+				auto it = s.byPid.find(pid);
+				if(it == s.byPid.end()) return false;
+				out = it->second;
+				return true;
+			}
+
+			bool FindByName(const string& pname, Entry& out){
+				int pid;
+				{
+					Shard& s = nameShard(pname);
+					std::shared_lock<std::shared_mutex> lock(s.mutex);
+					auto it = s.byName.find(pname);
+					if(it == s.byName.end()) return false;
+					pid = it->second;
+				}
+				return FindByPid(pid, out);
+			}
+
+			std::shared_ptr<console::Console> View(int pid){
+				Shard& s = pidShard(pid);
+				std::shared_lock<std::shared_mutex> lock(s.mutex);
+				auto it = s.byPid.find(pid);
+				return (it == s.byPid.end()) ? nullptr : it->second.view;
+			}
+
+			void SetState(int pid, State state){
+				Shard& s = pidShard(pid);
+				std::unique_lock<std::shared_mutex> lock(s.mutex);
+				auto it = s.byPid.find(pid);
+				if(it != s.byPid.end()) it->second.state = state;
+			}
+
+			//Finished process left memory: keep the entry so lookups can say where it went, free its console.
+			void Archive(int pid){
+				std::shared_ptr<console::Console> dropped;
+				{
+					Shard& s = pidShard(pid);
+					std::unique_lock<std::shared_mutex> lock(s.mutex);
+					auto it = s.byPid.find(pid);
+					if(it == s.byPid.end()) return;
+					it->second.state = Archived;
+					dropped.swap(it->second.view); //destroyed after the lock is released
+				}
+			}
+
+			uint64_t Size(){ return count.load(std::memory_order_relaxed); }
+
+		private:
+			struct Shard {
+				std::shared_mutex mutex;
+				std::unordered_map<int, Entry> byPid;
+				std::unordered_map<string, int> byName;
+			};
+			Shard shards[numShards];
+			std::atomic<uint64_t> count{0};
+
+			Shard& pidShard(int pid){ return shards[(unsigned)pid % numShards]; }
+			Shard& nameShard(const string& pname){ return shards[std::hash<string>()(pname) % numShards]; }
+	};
+}
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef processPoolH
+#define processPoolH
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <string>
+#include <sstream>
+
+namespace processPool {
+
+	//Size-class pool for everything a process owns: its Console/PCB nodes, program text, and log lines.
+	//Blocks are rounded up to a power of two (16 B .. 64 KB) and carved out of 256 KB slabs. A freed block goes back on its
+	//class' free list and is handed to the next process, so a long scheduler-start run stops growing once it reaches its
+	//working set instead of churning malloc. Anything bigger than the largest class goes straight to operator new.
+	class SizeClassPool {
+		public:
+			static const size_t minClass = 16;
+			static const int numClasses = 13;				//16 << 12 = 64 KB
+			static const size_t maxClass = minClass << (numClasses - 1);
+			static const size_t slabSize = 256 * 1024;
+
+			std::atomic<uint64_t> slabBytes{0};		//reserved from the OS, never given back
+			std::atomic<uint64_t> liveBytes{0};		//handed out and not freed yet (rounded up to the class size)
+
+			void* Allocate(size_t bytes){
+				if(bytes > maxClass) return ::operator new(bytes);
+				int c = ClassOf(bytes);
+				size_t size = minClass << c;
+				SizeClass& sc = classes[c];
+				void* p;
+				{
+					std::lock_guard<std::mutex> lock(sc.mutex);
+					if(sc.free != nullptr){
+						p = sc.free;
+						sc.free = sc.free->next;
+					}
+					else{
+						if(sc.left < size){
+							sc.bump = (char*)::operator new(slabSize);
+							sc.left = slabSize;
+							slabBytes.fetch_add(slabSize, std::memory_order_relaxed);
+						}
+						p = sc.bump;
+						sc.bump += size;
+						sc.left -= size;
+					}
+				}
+				liveBytes.fetch_add(size, std::memory_order_relaxed);
+				return p;
+			}
+
+			void Free(void* p, size_t bytes){
+				if(p == nullptr) return;
+				if(bytes > maxClass){
+					::operator delete(p);
+					return;
+				}
+				int c = ClassOf(bytes);
+				SizeClass& sc = classes[c];
+				{
+					std::lock_guard<std::mutex> lock(sc.mutex);
+					Block* b = (Block*)p;
+					b->next = sc.free;
+					sc.free = b;
+				}
+				liveBytes.fetch_sub(minClass << c, std::memory_order_relaxed);
+			}
+
+		private:
+			struct Block { Block* next; };
+			struct SizeClass {
+				std::mutex mutex;
+				Block* free = nullptr;
+				char* bump = nullptr;	//unused tail of the newest slab
+				size_t left = 0;
+			};
+			SizeClass classes[numClasses];
+
+			static int ClassOf(size_t bytes){
+				int c = 0;
+				while((minClass << c) < bytes) c++;
+				return c;
+			}
+	};
+
+	//The one pool everything shares. Deliberately never destroyed: a function-local static pool would be destroyed in reverse
+	//order of construction, before any static or thread_local constructed ahead of the first Shared() call, and those can
+	//still hold pooled strings and rows they free in their destructors. The OS gets the slabs back anyway.
+	inline SizeClassPool& Shared(){
+		static SizeClassPool* pool = new SizeClassPool();
+		return *pool;
+	}
+
+	//Standard allocator on top of the shared pool, for containers and strings.
+	template<class T>
+	struct PoolAllocator {
+		using value_type = T;
+
+		PoolAllocator() noexcept {}
+		template<class U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n){ return (T*)Shared().Allocate(n * sizeof(T)); }
+		void deallocate(T* p, size_t n){ Shared().Free(p, n * sizeof(T)); }
+
+		template<class U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+		template<class U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+	};
+
+	using String = std::basic_string<char, std::char_traits<char>, PoolAllocator<char>>;
+	using OStringStream = std::basic_ostringstream<char, std::char_traits<char>, PoolAllocator<char>>;
+}
+
+#endif
@@ -0,0 +1,287 @@
+#pragma once
+#ifndef processTableH
+#define processTableH
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ctime>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+
+#include "process.h"
+#include "processPool.h"
+#include "wallClock.h"
+
+using std::string;
+using std::vector;
+
+namespace processTable {
+
+	//One line of screen -ls / report-util. Filled in when a process changes state and never modified after that,
+	//so readers can go through it without holding any lock.
+	struct Row {
+		int pid = -1;
+		string pname;
+		time_t arrivalTime = 0;
+		time_t startTime = 0;		//0: hasn't started yet
+		time_t finishTime = 0;		//0: hasn't finished yet
+		uint64_t arrivalNs = 0;		//the same three in ns (latency::NowNs), for wait and turnaround below a second
+		uint64_t startNs = 0;
+		uint64_t finishNs = 0;
+		int currLine = 0;
+		int lineCount = 0;
+		int core = -1;				//core it's on, or last ran on once finished
+		long memory = 0;			//bytes resident when the row was taken
+	};
+
+	inline Row RowOf(process::Process& p, int memPerFrame){
+		Row r;
+		r.pid = p.pid;
+		r.pname = p.pname;
+		r.arrivalTime = p.arrivalTime;
+		r.startTime = p.startTime;
+		r.finishTime = p.finishTime;
+		r.arrivalNs = p.arrivalNs;
+		r.startNs = p.startNs;
+		r.finishNs = p.finishNs;
+		r.currLine = p.currLine;
+		r.lineCount = p.lineCount;
+		r.core = (p.core >= 0) ? p.core : p.lastCore;
+		r.memory = (long)p.getMemorySize() * memPerFrame;
+		return r;
+	}
+
+	//FIFO of rows for a queue that's only pushed at the back and popped at the front (the ready queue, the finished window).
+	//Rows live in fixed-size chunks linked front to back. A pushed row is never touched again and a chunk is only freed when
+	//nothing references it, so a View is two sequence numbers and a pointer to the first chunk: O(1) to take, and it stays
+	//valid while the owner keeps pushing and popping. Push/Pop/Snapshot must be serialized by the owner's lock.
+	class RowLog {
+		public:
+			static const uint64_t chunkSize = 256;
+
+			struct Chunk {
+				Row rows[chunkSize];
+				std::shared_ptr<Chunk> next;	//set once, before any view can reach past this chunk
+			};
+
+			class View {
+				public:
+					uint64_t Size() const { return tail - head; }
+					bool Empty() const { return tail == head; }
+
+					template<class F> void ForEach(F fn) const {
+						const Chunk* c = first.get();
+						for(uint64_t seq = head; seq < tail; ++seq){
+							if(seq != head && seq % chunkSize == 0) c = c->next.get();
+							fn(c->rows[seq % chunkSize]);
+						}
+					}
+
+				private:
+					friend class RowLog;
+					uint64_t head = 0;
+					uint64_t tail = 0;
+					std::shared_ptr<const Chunk> first;	//chunk holding `head`
+			};
+
+			void Push(Row r){
+				if(tail % chunkSize == 0){
+					std::shared_ptr<Chunk> c = std::allocate_shared<Chunk>(processPool::PoolAllocator<Chunk>());
+					if(last) last->next = c;
+					else first = c;
+					last = c;
+				}
+				last->rows[tail % chunkSize] = std::move(r);
+				tail++;
+			}
+
+			const Row& Front(){ return first->rows[head % chunkSize]; }
+
+			void Pop(){
+				if(head == tail) return;
+				head++;
+				if(head % chunkSize == 0){
+					if(first == last) last = first->next; //nothing was pushed past it, both become null
+					first = first->next;
+				}
+			}
+
+			uint64_t Size(){ return tail - head; }
+
+			View Snapshot(){
+				View v;
+				v.head = head;
+				v.tail = tail;
+				v.first = first;
+				return v;
+			}
+
+		private:
+			uint64_t head = 0;	//sequence number of the oldest row still in the queue
+			uint64_t tail = 0;	//sequence number the next pushed row gets
+			std::shared_ptr<Chunk> first;
+			std::shared_ptr<Chunk> last;
+	};
+
+	//Milliseconds spent in the ready queue before first getting a core, -1 if it hasn't started.
+	inline double WaitTime(const Row& r){ return (r.startNs && r.arrivalNs) ? (r.startNs - r.arrivalNs) / 1e6 : -1; }
+	//Milliseconds from arrival to finish, -1 if it hasn't finished.
+	inline double TurnaroundTime(const Row& r){ return (r.finishNs && r.arrivalNs) ? (r.finishNs - r.arrivalNs) / 1e6 : -1; }
+
+	//Everything screen -ls and report-util print, as of one instant.
+	struct Snapshot {
+		RowLog::View ready;
+		vector<Row> running;
+		RowLog::View finished;
+		uint64_t archived = 0;
+		time_t taken = 0;
+		double utilization = 0;				//busy share of all core ticks, percent
+		vector<double> coreUtilization;		//same, per core
+	};
+
+	template<class F> void ForEach(const RowLog::View& rows, F fn){ rows.ForEach(fn); }
+	template<class F> void ForEach(const vector<Row>& rows, F fn){ for(const Row& r : rows) fn(r); }
+	inline bool Empty(const RowLog::View& rows){ return rows.Empty(); }
+	inline bool Empty(const vector<Row>& rows){ return rows.empty(); }
+
+	//n must be at least 32 (see wallClock::Format).
+	inline void FormatTime(char* out, size_t n, time_t t){
+		if(t == 0){ out[0] = '\0'; return; }
+		wallClock::Format(out, n, t, wallClock::Listing);
+	}
+
+	//The process table used by screen -ls and report-util. Running rows show the core and resident memory instead of the finish time.
+	template<class Rows>
+	void WriteTable(std::ostream& out, const Rows& rows, bool running = false){
+		using std::left;
+		using std::right;
+		using std::setw;
+		out << left << setw(4) << "PID";
+		out << left << "\t" << setw(20) << "Name";
+		out << left << "\t" << setw(30) << "Time arrived";
+		out << left << "\t" << setw(30) << "Time started";
+		if(!running)
+			out << left << "\t" << setw(30) << "Time finished";
+		else
+			out << left << "\t" << setw(8) << "Core";
+		out << left << "\t" << setw(15) << "Current Line";
+		out << left << "\t" << setw(15) << "Total Lines";
+		out << left << "\t" << setw(17) << "Progress";
+		if(running)
+			out << left << "\t" << setw(15) << "Memory Utilization";
+		out << "\n";
+
+		if(Empty(rows)){
+			out << "No processes to be listed." << "\n";
+		}
+		char time[32];
+		char timeS[32];
+		char timeF[32];
+		ForEach(rows, [&](const Row& r){
+			FormatTime(time, sizeof(time), r.arrivalTime);
+			FormatTime(timeS, sizeof(timeS), r.startTime);
+			FormatTime(timeF, sizeof(timeF), r.finishTime);
+			int percentage = (r.lineCount > 0) ? ((double)r.currLine / (double)r.lineCount) * 100.00 : 0;
+
+			out << left << setw(4) << r.pid;
+			out << left << "\t" << setw(20) << r.pname;
+			out << left << "\t" << setw(30) << time;
+			out << left << "\t" << setw(30) << timeS;
+			if(!running)
+				out << left << "\t" << setw(30) << timeF;
+			else
+				out << left << "\t" << setw(8) << r.core;
+			out << left << "\t" << setw(15) << r.currLine;
+			out << left << "\t" << setw(15) << r.lineCount;
+			out << right << "\t" << setw(3) << percentage;
+			out << left << "% [";
+			for(int i = 0; i < 10; i++){
+				out << (i < percentage / 10 ? '#' : '-');
+			}
+			out << "]";
+			if(running)
+				out << "     " << left << setw(15) << r.memory;
+			out << "\n";
+		});
+		out << "\n" << "\n";
+	}
+
+	//report-util --format. Text is the padded table, the other two are one line per process for dashboards.
+	enum Format { Text, CSV, JSONL };
+
+	//Rows are formatted into a fixed buffer and written straight to the stream, no per-row strings or setw.
+	class RowWriter {
+		public:
+			RowWriter(std::ostream& o, Format f) : out(o), format(f) {}
+
+			void Header(){
+				if(format == CSV)
+					write("state,pid,name,arrival,start,finish,wait_ms,turnaround_ms,core,current_line,total_lines,memory_bytes\n");
+			}
+
+			template<class Rows>
+			void Section(const char* state, const Rows& rows){
+				ForEach(rows, [&](const Row& r){ WriteRow(state, r); });
+			}
+
+			void WriteRow(const char* state, const Row& r){
+				char name[160];
+				int n;
+				if(format == CSV){
+					quoteCSV(name, sizeof(name), r.pname);
+					n = snprintf(line, sizeof(line), "%s,%d,%s,%lld,%lld,%lld,%.3f,%.3f,%d,%d,%d,%ld\n", state, r.pid, name,
+						(long long)r.arrivalTime, (long long)r.startTime, (long long)r.finishTime, WaitTime(r), TurnaroundTime(r),
+						r.core, r.currLine, r.lineCount, r.memory);
+				}
+				else{
+					escapeJSON(name, sizeof(name), r.pname);
+					n = snprintf(line, sizeof(line), "{\"state\":\"%s\",\"pid\":%d,\"name\":\"%s\",\"arrival\":%lld,\"start\":%lld,\"finish\":%lld,"
+						"\"wait_ms\":%.3f,\"turnaround_ms\":%.3f,\"core\":%d,\"current_line\":%d,\"total_lines\":%d,\"memory_bytes\":%ld}\n",
+						state, r.pid, name, (long long)r.arrivalTime, (long long)r.startTime, (long long)r.finishTime,
+						WaitTime(r), TurnaroundTime(r), r.core, r.currLine, r.lineCount, r.memory);
+				}
+				out.write(line, std::min(n, (int)sizeof(line) - 1));
+			}
+
+		private:
+			std::ostream& out;
+			Format format;
+			char line[512];
+
+			void write(const char* s){ out.write(s, strlen(s)); }
+
+			//Names are quoted only when they need it. Long names are cut to fit the buffer.
+			static void quoteCSV(char* dst, size_t n, const string& s){
+				if(s.find_first_of(",\"\n\r") == string::npos){
+					snprintf(dst, n, "%s", s.c_str());
+					return;
+				}
+				size_t j = 0;
+				dst[j++] = '"';
+				for(char c : s){
+					if(j + 4 >= n) break;
+					if(c == '"') dst[j++] = '"';
+					dst[j++] = c;
+				}
+				dst[j++] = '"';
+				dst[j] = '\0';
+			}
+
+			static void escapeJSON(char* dst, size_t n, const string& s){
+				size_t j = 0;
+				for(unsigned char c : s){
+					if(j + 8 >= n) break;
+					if(c == '"' || c == '\\'){ dst[j++] = '\\'; dst[j++] = c; }
+					else if(c < 0x20) j += snprintf(dst + j, n - j, "\\u%04x", c);
+					else dst[j++] = c;
+				}
+				dst[j] = '\0';
+			}
+	};
+}
+
+#endif
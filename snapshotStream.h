@@ -0,0 +1,265 @@
+#pragma once
+#ifndef snapshotStreamH
+#define snapshotStreamH
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <atomic>
+
+#include "frame.h"
+#include "memoryAllocator.h"
+
+using std::string;
+using std::vector;
+using std::map;
+
+namespace snapshotStream {
+
+	//On-disk layout. <prefix>.bin holds the records back to back, <prefix>.idx one IndexEntry per record so a quantum can be
+	//found with a binary search, <prefix>.names the pid -> process name table.
+	//Every keyframeEvery-th record is a keyframe listing every used frame; the rest only list frames whose owner changed.
+	enum RecordKind : uint32_t { Keyframe = 0, Delta = 1 };
+
+	struct RecordHeader {
+		uint32_t quantum;
+		uint32_t kind;
+		int64_t time;		//epoch seconds when the quantum ended
+		uint32_t numFrames;
+		uint32_t count;		//FrameEntry records that follow
+	};
+
+	struct FrameEntry {
+		int32_t frame;
+		int32_t pid;		//-1 when the frame became free
+	};
+
+	struct IndexEntry {
+		uint32_t quantum;
+		uint32_t kind;
+		uint64_t offset;	//where the record starts in the .bin file
+	};
+
+	//Append-only writer. Capture() only copies the owner map and hands it to a background thread, which diffs it against
+	//the previous one and writes the record, so the scheduler never waits on disk.
+	class SnapshotWriter {
+		public:
+			static const uint32_t keyframeEvery = 256;
+
+			~SnapshotWriter(){
+				Close();
+			}
+
+			bool Open(const string& filePrefix){
+				Close();
+				prefix = filePrefix;
+				bin = fopen((prefix + ".bin").c_str(), "wb");
+				idx = fopen((prefix + ".idx").c_str(), "wb");
+				names = fopen((prefix + ".names").c_str(), "wb");
+				if(!bin || !idx || !names){
+					std::cerr << "Error: Could not open " << prefix << ".bin/.idx/.names for writing.\n";
+					closeFiles();
+					return false;
+				}
+				setvbuf(bin, NULL, _IOFBF, 1 << 20);
+				running = true;
+				writer = std::thread(&SnapshotWriter::writerLoop, this);
+				return true;
+			}
+
+			bool IsOpen(){ return running; }
+
+			//Hot path, called by the scheduler once per quantum. Only call it from one thread.
+			void Capture(uint32_t quantum, memoryAllocator::MemoryAllocator& memory){
+				if(!running) return;
+				Pending job;
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					if(!spare.empty()){ //reuse an old buffer so steady state doesn't allocate
+						job.pids.swap(spare.back());
+						spare.pop_back();
+					}
+				}
+				job.quantum = quantum;
+				job.time = (int64_t)time(NULL);
+				memory.OwnerMap(job.pids, seen, job.newNames);
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					pending.push_back(std::move(job));
+				}
+				cv.notify_one();
+			}
+
+			//Drains whatever is still queued, then closes the files.
+			void Close(){
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					if(!running) return;
+					running = false;
+				}
+				cv.notify_one();
+				if(writer.joinable()) writer.join();
+				closeFiles();
+			}
+
+		private:
+			struct Pending {
+				uint32_t quantum = 0;
+				int64_t time = 0;
+				vector<int> pids;
+				vector<std::pair<int, string>> newNames;
+			};
+
+			string prefix;
+			FILE* bin = NULL;
+			FILE* idx = NULL;
+			FILE* names = NULL;
+			std::thread writer;
+			std::mutex queueMutex;
+			std::condition_variable cv;
+			std::deque<Pending> pending;
+			vector<vector<int>> spare;
+			std::atomic<bool> running{false};
+			vector<char> seen;			//pids whose name is already in .names, only touched by Capture's caller
+			vector<int> previous;		//owner map of the last record written
+			uint32_t written = 0;
+			vector<FrameEntry> entries;
+
+			void writerLoop(){
+				while(true){
+					Pending job;
+					{
+						std::unique_lock<std::mutex> lock(queueMutex);
+						cv.wait(lock, [this]{ return !pending.empty() || !running; });
+						if(pending.empty()) break;
+						job = std::move(pending.front());
+						pending.pop_front();
+					}
+					writeRecord(job);
+					bool idle;
+					{
+						std::lock_guard<std::mutex> lock(queueMutex);
+						spare.push_back(std::move(job.pids));
+						idle = pending.empty();
+					}
+					//Caught up: flush so snapshot-read can see everything written so far. .bin goes first so the index never points past it.
+					if(idle){
+						fflush(bin);
+						fflush(idx);
+					}
+				}
+				fflush(bin);
+				fflush(idx);
+				fflush(names);
+			}
+
+			void writeRecord(Pending& job){
+				for(auto& n : job.newNames){
+					int32_t pid = n.first;
+					uint32_t len = n.second.size();
+					fwrite(&pid, sizeof(pid), 1, names);
+					fwrite(&len, sizeof(len), 1, names);
+					fwrite(n.second.data(), 1, len, names);
+				}
+				fflush(names); //names are tiny and the reader needs them for any record that follows
+
+				bool keyframe = written % keyframeEvery == 0 || previous.size() != job.pids.size();
+				entries.clear();
+				for(size_t f = 0; f < job.pids.size(); ++f){
+					if(keyframe ? job.pids[f] != -1 : job.pids[f] != previous[f])
+						entries.push_back({(int32_t)f, job.pids[f]});
+				}
+
+				IndexEntry index{job.quantum, keyframe ? (uint32_t)Keyframe : (uint32_t)Delta, (uint64_t)ftell(bin)};
+				RecordHeader header{job.quantum, index.kind, job.time, (uint32_t)job.pids.size(), (uint32_t)entries.size()};
+				fwrite(&header, sizeof(header), 1, bin);
+				if(!entries.empty()) fwrite(entries.data(), sizeof(FrameEntry), entries.size(), bin);
+				fwrite(&index, sizeof(index), 1, idx);
+
+				previous.swap(job.pids);
+				written++;
+			}
+
+			void closeFiles(){
+				if(bin) fclose(bin);
+				if(idx) fclose(idx);
+				if(names) fclose(names);
+				bin = idx = names = NULL;
+			}
+	};
+
+	//Rebuilds the memory map as of a quantum: binary search the index, seek to the keyframe before it and replay deltas.
+	//Returns false if the stream doesn't have that quantum.
+	inline bool ReadSnapshot(const string& prefix, uint32_t quantum, vector<Frame>& frames, int memPerFrame, time_t& when){
+		FILE* idx = fopen((prefix + ".idx").c_str(), "rb");
+		if(!idx) return false;
+		vector<IndexEntry> index;
+		IndexEntry e;
+		while(fread(&e, sizeof(e), 1, idx) == 1) index.push_back(e);
+		fclose(idx);
+
+		//Quanta are written in order, so the index is sorted.
+		size_t lo = 0, hi = index.size();
+		while(lo < hi){
+			size_t mid = (lo + hi) / 2;
+			if(index[mid].quantum < quantum) lo = mid + 1;
+			else hi = mid;
+		}
+		if(lo == index.size() || index[lo].quantum != quantum) return false;
+		size_t start = lo;
+		while(start > 0 && index[start].kind != Keyframe) start--;
+
+		map<int, string> pnames;
+		FILE* names = fopen((prefix + ".names").c_str(), "rb");
+		if(names){
+			int32_t pid;
+			uint32_t len;
+			while(fread(&pid, sizeof(pid), 1, names) == 1 && fread(&len, sizeof(len), 1, names) == 1){
+				string name(len, '\0');
+				if(len > 0 && fread(&name[0], 1, len, names) != len) break;
+				pnames[pid] = name;
+			}
+			fclose(names);
+		}
+
+		FILE* bin = fopen((prefix + ".bin").c_str(), "rb");
+		if(!bin) return false;
+		fseek(bin, (long)index[start].offset, SEEK_SET);
+		vector<int> pids;
+		vector<FrameEntry> entries;
+		RecordHeader header{};
+		for(size_t r = start; r <= lo; ++r){
+			if(fread(&header, sizeof(header), 1, bin) != 1) break;
+			if(header.kind == Keyframe) pids.assign(header.numFrames, -1);
+			entries.resize(header.count);
+			if(header.count > 0 && fread(entries.data(), sizeof(FrameEntry), header.count, bin) != header.count) break;
+			for(auto& fe : entries) if(fe.frame >= 0 && (size_t)fe.frame < pids.size()) pids[fe.frame] = fe.pid;
+		}
+		fclose(bin);
+
+		frames.clear();
+		for(size_t i = 0; i < pids.size(); ++i){
+			Frame f;
+			f.id = i;
+			f.startAddress_i = i * memPerFrame;
+			f.endAddress_i = f.startAddress_i + memPerFrame - 1;
+			if(pids[i] != -1){
+				auto n = pnames.find(pids[i]);
+				f.pid = (n != pnames.end()) ? n->second : std::to_string(pids[i]);
+			}
+			frames.push_back(f);
+		}
+		when = (time_t)header.time;
+		return !frames.empty();
+	}
+}
+
+#endif
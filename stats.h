@@ -9,8 +9,14 @@ struct VMStat {
 
     uint64_t idleCpuTicks;
     uint64_t activeCpuTicks;
+    uint64_t switchCpuTicks;
+    uint64_t sleepCpuTicks;
     uint64_t totalCpuTicks;
 
     uint64_t pagedIn;
     uint64_t pagedOut;
+
+    uint64_t contextSwitches;
+    uint64_t busyCores;     // cores running a process at the moment of the read
+    uint64_t numCores;
 };
@@ -0,0 +1,130 @@
+#pragma once
+#ifndef terminalScreenH
+#define terminalScreenH
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace terminalScreen {
+
+	//Windows consoles only understand escape sequences once virtual terminal processing is switched on. Elsewhere it's a no-op.
+	inline bool EnableAnsi(){
+#ifdef _WIN32
+		HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+		DWORD mode = 0;
+		if(out == INVALID_HANDLE_VALUE || !GetConsoleMode(out, &mode)) return false;
+		return SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+		return true;
+#endif
+	}
+
+	//What clear and process-smi used to do with system("cls"), minus the shell, on platforms without cls.
+	inline void Clear(){
+#ifdef _WIN32
+		system("cls");
+#else
+		std::cout << "\x1b[2J\x1b[H" << std::flush;
+#endif
+	}
+
+	//Two copies of the screen as lines of text: the one on the terminal and the one being built. Render writes only the
+	//cells that differ, each changed run preceded by a cursor move, so a refresh where one counter ticked is a few bytes.
+	class Screen {
+		public:
+			//Start building the next frame.
+			void Begin(){
+				back.clear();
+			}
+
+			void Print(const char* format, ...){
+				char line[512];
+				va_list args;
+				va_start(args, format);
+				vsnprintf(line, sizeof(line), format, args);
+				va_end(args);
+				back.emplace_back(line);
+			}
+
+			//Escape sequences that turn the terminal from the last frame into this one. The first frame clears and draws everything.
+			string Render(){
+				string out;
+				if(!drawn){
+					out += "\x1b[2J";
+					front.clear();
+					drawn = true;
+				}
+				for(size_t row = 0; row < back.size(); row++){
+					const string empty;
+					diffLine(out, (int)row + 1, row < front.size() ? front[row] : empty, back[row]);
+				}
+				for(size_t row = back.size(); row < front.size(); row++){
+					moveTo(out, (int)row + 1, 1);
+					out += "\x1b[2K";
+				}
+				moveTo(out, (int)back.size() + 1, 1);
+				front.swap(back);
+				return out;
+			}
+
+			//Next Render redraws everything, e.g. after something else wrote to the terminal.
+			void Invalidate(){ drawn = false; }
+
+		private:
+			vector<string> front;
+			vector<string> back;
+			bool drawn = false;
+
+			static void moveTo(string& out, int row, int col){
+				char move[32];
+				snprintf(move, sizeof(move), "\x1b[%d;%dH", row, col);
+				out += move;
+			}
+
+			//Unchanged gaps shorter than a cursor move are rewritten instead of jumped over.
+			static void diffLine(string& out, int row, const string& before, const string& after){
+				const size_t gap = 6;
+				size_t common = std::min(before.size(), after.size());
+				size_t i = 0;
+				while(i < common){
+					if(before[i] == after[i]){ i++; continue; }
+					size_t start = i, end = i + 1, same = 0;
+					for(size_t j = i + 1; j < common && same < gap; j++){
+						if(before[j] == after[j]) same++;
+						else{ same = 0; end = j + 1; }
+					}
+					moveTo(out, row, (int)start + 1);
+					out.append(after, start, end - start);
+					i = end;
+				}
+				if(after.size() > common){
+					moveTo(out, row, (int)common + 1);
+					out.append(after, common, string::npos);
+				}
+				else if(before.size() > common){
+					moveTo(out, row, (int)common + 1);
+					out += "\x1b[K";
+				}
+			}
+	};
+}
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef tlbH
+#define tlbH
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+
+using std::vector;
+
+namespace tlb {
+
+	//Small set-associative translation cache that sits in front of a process' page table. One per core.
+	//Entries are tagged with an ASID (the pid) so they can either survive a context switch or be flushed, depending on tlb-mode.
+	class TLB {
+		public:
+			//Only the owning core bumps these, vmstat and process-smi read them from other threads.
+			std::atomic<uint64_t> hits{0};
+			std::atomic<uint64_t> misses{0};
+			std::atomic<uint64_t> flushes{0};
+
+			TLB(int numSets = 16, int numWays = 4) : sets(numSets), ways(numWays), entries(numSets * numWays) {}
+
+			//Returns true and fills `frame` if (asid, vpn) is cached. Counts nothing: the entry may still turn out to be stale,
+			//so the caller reports the outcome with NoteHit/NoteMiss once it has checked.
+			bool Lookup(int asid, int vpn, int& frame){
+				Entry* set = &entries[SetOf(asid, vpn) * ways];
+				for(int i = 0; i < ways; i++){
+					if(set[i].valid && set[i].asid == asid && set[i].vpn == vpn){
+						set[i].lastUse = ++clock;
+						frame = set[i].frame;
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void NoteHit(){ hits.fetch_add(1, std::memory_order_relaxed); }
+			void NoteMiss(){ misses.fetch_add(1, std::memory_order_relaxed); }
+
+			//Cache a translation, replacing the least recently used way of its set.
+			void Insert(int asid, int vpn, int frame){
+				Entry* set = &entries[SetOf(asid, vpn) * ways];
+				Entry* victim = &set[0];
+				for(int i = 0; i < ways; i++){
+					if(set[i].valid && set[i].asid == asid && set[i].vpn == vpn){ victim = &set[i]; break; }
+					if(!set[i].valid){ victim = &set[i]; break; }
+					if(set[i].lastUse < victim->lastUse) victim = &set[i];
+				}
+				victim->valid = true;
+				victim->asid = asid;
+				victim->vpn = vpn;
+				victim->frame = frame;
+				victim->lastUse = ++clock;
+			}
+
+			//Drop an entry that turned out to be stale (its page was evicted after it was cached).
+			void Invalidate(int asid, int vpn){
+				Entry* set = &entries[SetOf(asid, vpn) * ways];
+				for(int i = 0; i < ways; i++){
+					if(set[i].valid && set[i].asid == asid && set[i].vpn == vpn) set[i].valid = false;
+				}
+			}
+
+			void Flush(){
+				for(Entry& e : entries) e.valid = false;
+				flushes.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			double HitRate(){
+				uint64_t h = hits.load(std::memory_order_relaxed);
+				uint64_t total = h + misses.load(std::memory_order_relaxed);
+				return (total > 0) ? ((double)h / total) * 100.0 : 0;
+			}
+
+		private:
+			struct Entry {
+				bool valid = false;
+				int asid = -1;
+				int vpn = -1;
+				int frame = -1;
+				uint64_t lastUse = 0;
+			};
+
+			int sets;
+			int ways;
+			vector<Entry> entries;	//sets * ways, one set after the other
+			uint64_t clock = 0;		//LRU stamp within a set
+
+			int SetOf(int asid, int vpn){
+				return (unsigned)(vpn ^ (asid * 7)) % sets;
+			}
+	};
+}
+
+#endif
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef traceH
+#define traceH
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <algorithm>
+
+#include "latency.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using std::vector;
+using std::string;
+
+namespace trace {
+
+	//Raw timestamp counter where there is one (a few ns, steady_clock can cost more than the rest of Emit), nanoseconds otherwise.
+	//Converted to time when the trace is dumped, from the two clock pairs taken at start and dump.
+	inline uint64_t Ticks(){
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return latency::NowNs();
+#endif
+	}
+
+	enum EventType : uint8_t { Enqueue = 0, Dispatch, Preempt, Sleep, Wake, AllocSuccess, AllocFail, Free, Finish };
+
+	inline const char* EventName(uint8_t type){
+		static const char* names[] = { "enqueue", "dispatch", "preempt", "sleep", "wake", "alloc-success", "alloc-fail", "free", "finish" };
+		return (type <= Finish) ? names[type] : "unknown";
+	}
+
+	//16 bytes, so a ring of them is just a flat array.
+	struct Event {
+		uint64_t ticks;		//Ticks()
+		int32_t pid;
+		uint8_t type;
+		uint8_t slot;
+		uint16_t unused;
+	};
+
+	//Single producer ring: only the thread that owns the slot writes to it, so pushing is a store and a release on head.
+	//When it's full the oldest events are overwritten.
+	class Ring {
+		public:
+			static const uint64_t capacity = 1 << 16;
+
+			Ring() : events(new Event[capacity]) {}
+
+			void Push(const Event& e){
+				uint64_t h = head.load(std::memory_order_relaxed);
+				events[h & (capacity - 1)] = e;
+				head.store(h + 1, std::memory_order_release);
+			}
+
+			//Starts a new session at the current head instead of rewinding it, so a producer pushing right now can't be
+			//torn by the reset: head only ever moves forward, and only the producer moves it.
+			void Clear(){ first.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+			//Copies out what's in the ring since Clear. Events the producer may have overwritten while we copied are dropped.
+			void CopyTo(vector<Event>& out){
+				uint64_t end = head.load(std::memory_order_acquire);
+				uint64_t begin = std::max(first.load(std::memory_order_acquire), (end > capacity) ? end - capacity : 0);
+				size_t start = out.size();
+				for(uint64_t i = begin; i < end; i++) out.push_back(events[i & (capacity - 1)]);
+				uint64_t after = head.load(std::memory_order_acquire);
+				if(after > capacity && after - capacity > begin){
+					uint64_t lost = std::min(after - capacity - begin, end - begin);
+					out.erase(out.begin() + start, out.begin() + start + lost);
+				}
+			}
+
+		private:
+			std::unique_ptr<Event[]> events;
+			std::atomic<uint64_t> head{0};
+			std::atomic<uint64_t> first{0};	//head when the current session started
+	};
+
+	//One ring per slot: a slot per core, then the round robin scheduler and the process generator.
+	//Emit is a relaxed load when tracing is off; when on, a counter read and a 16 byte store into the caller's own ring.
+	class Tracer {
+		public:
+			void SetSlots(int n){
+				rings.clear();
+				for(int i = 0; i < n; i++) rings.emplace_back(new Ring());
+			}
+
+			bool Enabled(){ return enabled.load(std::memory_order_relaxed); }
+
+			void Start(){
+				startNs = latency::NowNs();
+				startTicks = Ticks();
+				for(auto& r : rings) r->Clear();
+				enabled.store(true, std::memory_order_release);
+			}
+
+			void Stop(){ enabled.store(false, std::memory_order_release); }
+
+			inline void Emit(int slot, EventType type, int pid){
+				if(!enabled.load(std::memory_order_relaxed)) return;
+				if(slot < 0 || slot >= (int)rings.size()) return;
+				rings[slot]->Push(Event{Ticks(), pid, type, (uint8_t)slot, 0});
+			}
+
+			//Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Each slot is a thread: a process is a slice from
+			//dispatch to preempt/finish, SLEEP a nested slice, everything else an instant event. nameOf turns a pid into a label.
+			bool Dump(const string& path, std::function<string(int)> nameOf, int numCores){
+				FILE* f = fopen(path.c_str(), "w");
+				if(f == NULL) return false;
+				vector<Event> events;
+				for(auto& r : rings) r->CopyTo(events);
+				uint64_t endTicks = Ticks();
+				uint64_t endNs = latency::NowNs();
+				double nsPerTick = (endTicks > startTicks) ? (double)(endNs - startNs) / (endTicks - startTicks) : 1.0;
+
+				fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+				for(size_t i = 0; i < rings.size(); i++){
+					string thread = (i < (size_t)numCores) ? "core " + std::to_string(i) : (i == (size_t)numCores) ? "rr scheduler" : "process generator";
+					fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", i ? ",\n" : "", i, thread.c_str());
+				}
+				bool first = rings.empty();
+				//A producer that saw tracing on before a restart can push an event from the previous session after Clear,
+				//its timestamp gives it away.
+				events.erase(std::remove_if(events.begin(), events.end(), [&](const Event& e){ return e.ticks < startTicks; }), events.end());
+				for(const Event& e : events){
+					double ts = (e.ticks - startTicks) * nsPerTick / 1000.0; //microseconds
+					string name = (e.type == Sleep || e.type == Wake) ? "sleep" : escape(nameOf(e.pid));
+					const char* ph = "i";
+					if(e.type == Dispatch || e.type == Sleep) ph = "B";
+					else if(e.type == Preempt || e.type == Finish || e.type == Wake) ph = "E";
+					fprintf(f, "%s{\"ph\":\"%s\",\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,%s\"args\":{\"pid\":%d}}",
+						first ? "" : ",\n", ph, (ph[0] == 'i') ? EventName(e.type) : name.c_str(), EventName(e.type), e.slot, ts,
+						(ph[0] == 'i') ? "\"s\":\"t\"," : "", e.pid);
+					first = false;
+				}
+				fprintf(f, "\n]}\n");
+				fclose(f);
+				return true;
+			}
+
+		private:
+			vector<std::unique_ptr<Ring>> rings;
+			std::atomic<bool> enabled{false};
+			uint64_t startNs = 0;
+			uint64_t startTicks = 0;
+
+			static string escape(const string& s){
+				string out;
+				for(unsigned char c : s){
+					if(c == '"' || c == '\\'){ out += '\\'; out += c; }
+					else if(c >= 0x20) out += c;
+				}
+				return out;
+			}
+	};
+}
+
+#endif
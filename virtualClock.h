@@ -0,0 +1,131 @@
+#pragma once
+#ifndef virtualClockH
+#define virtualClockH
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "cpuCore.h"
+
+using std::vector;
+
+namespace virtualClock {
+
+	//Time in ticks, for workload record/replay and the batch makespan. Every slot (a core, and the round robin scheduler
+	//when it runs processes) counts its own ticks in a cpucore::Ticks, and the clock reads as the busiest slot's count.
+	//
+	//Real time (the default): a tick is delays-per-exec of sleeping and the clock only measures.
+	//Virtual time (--sweep): nothing sleeps. A slot with work ticks as fast as it can, but never more than `slack` ticks
+	//ahead of the slowest slot with work, or past the horizon: the tick the generator's next process arrives at. A slot
+	//with nothing to do parks instead of ticking, and when it gets work it catches up on the ticks it missed, as idle.
+	class Clock {
+		public:
+			static const uint64_t slack = 8;
+			static const uint64_t never = UINT64_MAX;
+
+			//In slot order: the cores, then the round robin scheduler. Before any slot starts ticking.
+			void AddSlot(cpucore::Ticks* ticks){ slots.emplace_back(new Slot(ticks)); }
+
+			void SetVirtual(bool on){ virtualTime.store(on, std::memory_order_release); }
+			bool Virtual() const { return virtualTime.load(std::memory_order_relaxed); }
+
+			uint64_t Now() const {
+				uint64_t now = floor.load(std::memory_order_acquire);
+				for(auto& s : slots) now = std::max(now, s->ticks->Total());
+				return now;
+			}
+
+			//After a slot spent a tick. Real time: sleep ms. Virtual time: hold the slot until it's allowed further.
+			void Spend(int slot, int ms){
+				if(!Virtual()){
+					if(ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+					return;
+				}
+				if(slot < 0 || slot >= (int)slots.size()) return;
+				uint64_t own = slots[slot]->ticks->Total();
+				for(int spins = 0; !released.load(std::memory_order_relaxed); spins++){
+					if(own < horizon.load(std::memory_order_acquire) && own <= slowest(-1, own) + slack) return;
+					if(spins < 64) std::this_thread::yield();
+					else std::this_thread::sleep_for(std::chrono::microseconds(50));
+				}
+			}
+
+			//Park when a slot runs out of work and unpark when it has some again, both under the ready queue's lock so
+			//the generator sees a consistent AllParked.
+			void Park(int slot){
+				if(slot >= 0 && slot < (int)slots.size()) slots[slot]->parked.store(true, std::memory_order_release);
+			}
+
+			void Unpark(int slot){
+				if(slot < 0 || slot >= (int)slots.size()) return;
+				Slot& s = *slots[slot];
+				if(!s.parked.load(std::memory_order_relaxed)) return;
+				if(Virtual()) catchUp(s, std::max(floor.load(std::memory_order_acquire), slowest(slot, 0)));
+				s.parked.store(false, std::memory_order_release);
+			}
+
+			//Nobody has work, so nothing happens until the next arrival and time can skip straight to it.
+			bool AllParked() const {
+				for(auto& s : slots)
+					if(!s->parked.load(std::memory_order_acquire)) return false;
+				return true;
+			}
+
+			//Generator: no slot ticks past tick until the process arriving there is queued (Arrive), never to lift it.
+			void HoldAt(uint64_t tick){ horizon.store(tick, std::memory_order_release); }
+
+			//A process arrived at tick: no slot picking it up starts before then.
+			void Arrive(uint64_t tick){
+				uint64_t f = floor.load(std::memory_order_relaxed);
+				while(f < tick && !floor.compare_exchange_weak(f, tick, std::memory_order_acq_rel)) {}
+			}
+
+			//Idle ticks for the time parked slots sat out, so utilization covers the whole run. Under the ready queue's lock.
+			void Settle(){
+				if(!Virtual()) return;
+				uint64_t now = Now();
+				for(auto& s : slots)
+					if(s->parked.load(std::memory_order_acquire)) catchUp(*s, now);
+			}
+
+			//Shutdown: let every slot held in Spend go.
+			void Release(){
+				released.store(true, std::memory_order_release);
+				horizon.store(never, std::memory_order_release);
+			}
+
+		private:
+			struct Slot {
+				explicit Slot(cpucore::Ticks* t) : ticks(t) {}
+				cpucore::Ticks* ticks;
+				std::atomic<bool> parked{true};	//slots start out with nothing to do
+			};
+			vector<std::unique_ptr<Slot>> slots;
+			std::atomic<bool> virtualTime{false};
+			std::atomic<bool> released{false};
+			std::atomic<uint64_t> horizon{never};
+			std::atomic<uint64_t> floor{0};	//latest arrival, nothing starts before it
+
+			//Ticks of the slowest slot with work, other than except. orElse if none has any.
+			uint64_t slowest(int except, uint64_t orElse = never) const {
+				uint64_t low = never;
+				for(size_t i = 0; i < slots.size(); i++){
+					if((int)i == except || slots[i]->parked.load(std::memory_order_acquire)) continue;
+					low = std::min(low, slots[i]->ticks->Total());
+				}
+				return (low == never) ? orElse : low;
+			}
+
+			static void catchUp(Slot& s, uint64_t target){
+				uint64_t own = s.ticks->Total();
+				if(target > own) s.ticks->idle.fetch_add(target - own, std::memory_order_relaxed);
+			}
+	};
+}
+
+#endif
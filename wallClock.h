@@ -0,0 +1,90 @@
+#pragma once
+#ifndef wallClockH
+#define wallClockH
+
+#include <ctime>
+#include <cstring>
+#include <string>
+
+using std::string;
+
+namespace wallClock {
+
+	//The two ways times are shown. Listing: screen -ls, report-util, process consoles. Log: PRINT output and memory snapshots.
+	enum Style {
+		Listing,	//01/31/2025, 01:02:03 PM
+		Log			//01/31/2025 01:02:03PM
+	};
+
+	inline void localTime(time_t t, struct tm& out){
+#ifdef _WIN32
+		localtime_s(&out, &t);
+#else
+		localtime_r(&t, &out);
+#endif
+	}
+
+	//Calendar time for t. localtime takes a lock in glibc and reads the zone rules, so each thread remembers the start of
+	//the last local hour it converted; anything in that hour only needs its minutes and seconds filled in.
+	//Offset changes happen on local hour boundaries, so the cached hour can't straddle one.
+	inline void Convert(time_t t, struct tm& out){
+		thread_local time_t hourStart = -1;
+		thread_local struct tm hour;
+		if(hourStart >= 0 && t >= hourStart && t < hourStart + 3600){
+			out = hour;
+			out.tm_min = (int)((t - hourStart) / 60);
+			out.tm_sec = (int)((t - hourStart) % 60);
+			return;
+		}
+		localTime(t, out);
+		hour = out;
+		hour.tm_min = hour.tm_sec = 0;
+		hourStart = t - out.tm_min * 60 - out.tm_sec;
+	}
+
+	//Writes t in the given style, no strftime (which goes through the locale). Returns the length. n must be at least 32.
+	inline int Format(char* out, size_t n, time_t t, Style style){
+		if(n < 32){ if(n) out[0] = '\0'; return 0; }
+		struct tm c;
+		Convert(t, c);
+		int hour12 = c.tm_hour % 12;
+		if(hour12 == 0) hour12 = 12;
+		int year = c.tm_year + 1900;
+		char* p = out;
+		auto two = [&](int v){ *p++ = (char)('0' + v / 10 % 10); *p++ = (char)('0' + v % 10); };
+		two(c.tm_mon + 1); *p++ = '/';
+		two(c.tm_mday); *p++ = '/';
+		two(year / 100); two(year % 100);
+		if(style == Listing) *p++ = ',';
+		*p++ = ' ';
+		two(hour12); *p++ = ':';
+		two(c.tm_min); *p++ = ':';
+		two(c.tm_sec);
+		if(style == Listing) *p++ = ' ';
+		*p++ = (c.tm_hour < 12) ? 'A' : 'P';
+		*p++ = 'M';
+		*p = '\0';
+		return (int)(p - out);
+	}
+
+	inline string Format(time_t t, Style style){
+		char text[32];
+		int len = Format(text, sizeof(text), t, style);
+		return string(text, len);
+	}
+
+	//Current time in the given style. Formatted at most once per second per thread; a burst of PRINTs in the same second
+	//gets the cached text back.
+	inline const char* Now(Style style){
+		thread_local time_t second[2] = { -1, -1 };
+		thread_local char text[2][32];
+		time_t now = time(NULL);
+		if(second[style] != now){
+			Format(text[style], sizeof(text[style]), now, style);
+			second[style] = now;
+		}
+		return text[style];
+	}
+}
+
+#endif
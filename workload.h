@@ -0,0 +1,134 @@
+#pragma once
+#ifndef workloadH
+#define workloadH
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+using std::string;
+using std::vector;
+
+namespace workload {
+
+	//Everything needed to build the same process again: the generator draws the size and line count, the seed drives
+	//the instruction stream (see process::Process). tick is the virtual time it arrived at, the busiest core's tick count.
+	struct Spec {
+		uint64_t tick = 0;
+		uint32_t seed = 0;
+		int32_t memory = 0;
+		int32_t lines = 0;
+		string name;
+	};
+
+	//On-disk layout: FileHeader, then one Record per process followed by its name (nameLength bytes, no terminator).
+	struct FileHeader {
+		char magic[4];		//"CSWL"
+		uint32_t version;
+	};
+
+	struct Record {
+		uint64_t tick;
+		uint32_t seed;
+		int32_t memory;
+		int32_t lines;
+		uint32_t nameLength;
+	};
+
+	static const uint32_t version = 2;	//2: ticks are per core, 1 (summed over cores) no longer replays
+
+	//Appends specs as the generator creates processes. workload record/stop open and close it from the input thread
+	//while the generator may be appending, so every call takes the lock.
+	class Recorder {
+		public:
+			~Recorder(){
+				Close();
+			}
+
+			bool Open(const string& path){
+				std::lock_guard<std::mutex> lock(mutex);
+				closeFile();
+				file = fopen(path.c_str(), "wb");
+				if(file == NULL){
+					std::cerr << "Error: Could not open " << path << " for writing.\n";
+					return false;
+				}
+				FileHeader header;
+				memcpy(header.magic, "CSWL", 4);
+				header.version = version;
+				fwrite(&header, sizeof(header), 1, file);
+				recorded = 0;
+				return true;
+			}
+
+			bool IsOpen(){
+				std::lock_guard<std::mutex> lock(mutex);
+				return file != NULL;
+			}
+
+			uint64_t Recorded(){
+				std::lock_guard<std::mutex> lock(mutex);
+				return recorded;
+			}
+
+			void Append(const Spec& s){
+				std::lock_guard<std::mutex> lock(mutex);
+				if(file == NULL) return;
+				Record r;
+				r.tick = s.tick;
+				r.seed = s.seed;
+				r.memory = s.memory;
+				r.lines = s.lines;
+				r.nameLength = (uint32_t)s.name.size();
+				fwrite(&r, sizeof(r), 1, file);
+				fwrite(s.name.data(), 1, s.name.size(), file);
+				recorded++;
+			}
+
+			void Close(){
+				std::lock_guard<std::mutex> lock(mutex);
+				closeFile();
+			}
+
+		private:
+			std::mutex mutex;
+			FILE* file = NULL;
+			uint64_t recorded = 0;
+
+			void closeFile(){
+				if(file) fclose(file);
+				file = NULL;
+			}
+	};
+
+	//Whole trace, in the order it was recorded (which is arrival order).
+	inline bool Load(const string& path, vector<Spec>& specs){
+		specs.clear();
+		FILE* file = fopen(path.c_str(), "rb");
+		if(file == NULL) return false;
+		FileHeader header;
+		if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "CSWL", 4) != 0 || header.version != version){
+			fclose(file);
+			return false;
+		}
+		Record r;
+		while(fread(&r, sizeof(r), 1, file) == 1){
+			Spec s;
+			s.tick = r.tick;
+			s.seed = r.seed;
+			s.memory = r.memory;
+			s.lines = r.lines;
+			s.name.resize(r.nameLength);
+			if(r.nameLength > 0 && fread(&s.name[0], 1, r.nameLength, file) != r.nameLength) break;
+			specs.push_back(s);
+		}
+		fclose(file);
+		return true;
+	}
+}
+
+#endif